@@ -7,6 +7,7 @@
 QT += core gui webenginewidgets
 QT += network
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+CONFIG += c++11
 
 TARGET = GpsView
 TEMPLATE = app
@@ -14,10 +15,60 @@ TEMPLATE = app
 
 SOURCES += main.cpp\
         mainwindow.cpp \
-    server.cpp
+    server.cpp \
+    dronesession.cpp \
+    telemetryingest.cpp \
+    telemetryparser.cpp \
+    telemetrybinary.cpp \
+    logmodel.cpp \
+    cameracapture.cpp \
+    previewkernel.cpp \
+    videowidget.cpp \
+    mapbridge.cpp \
+    mapcache.cpp \
+    mapcachehandler.cpp \
+    coordtransform.cpp \
+    trackstore.cpp \
+    flightrecorder.cpp \
+    replaysource.cpp \
+    videorecorder.cpp \
+    perfstats.cpp \
+    perfpanel.cpp \
+    logging.cpp \
+    trace.cpp \
+    timeseries.cpp \
+    telemetrychart.cpp \
+    deadreckoning.cpp \
+    geotagger.cpp
 
 HEADERS  += mainwindow.h \
-    server.h
+    server.h \
+    dronesession.h \
+    telemetryingest.h \
+    spscqueue.h \
+    telemetrysample.h \
+    telemetryparser.h \
+    telemetrybinary.h \
+    logmodel.h \
+    cameracapture.h \
+    previewkernel.h \
+    videowidget.h \
+    mapbridge.h \
+    mapcache.h \
+    mapcachehandler.h \
+    coordtransform.h \
+    trackstore.h \
+    flightrecorder.h \
+    replaysource.h \
+    videorecorder.h \
+    perfstats.h \
+    perfpanel.h \
+    logging.h \
+    trace.h \
+    timeseries.h \
+    telemetrychart.h \
+    deadreckoning.h \
+    geotagger.h
 
 FORMS    += mainwindow.ui
 
@@ -31,8 +82,13 @@ RESOURCES += \
 #                /usr/include/opencv
 INCLUDEPATH += /usr/local/include
 
+# OpenCV 3 起 VideoWriter 在 videoio 中，imwrite/imencode 在 imgcodecs 中
 #LIBS            += /usr/lib/x86_64-linux-gnu/libopencv_highgui.so \
-#                    /usr/lib/x86_64-linux-gnu/libopencv_core.so
+#                    /usr/lib/x86_64-linux-gnu/libopencv_core.so \
+#                    /usr/lib/x86_64-linux-gnu/libopencv_videoio.so \
+#                    /usr/lib/x86_64-linux-gnu/libopencv_imgcodecs.so
 LIBS            += /usr/local/lib/libopencv_highgui.dylib \
                     /usr/local/lib/libopencv_core.dylib \
-                     /usr/local/lib/libopencv_video.dylib
+                     /usr/local/lib/libopencv_video.dylib \
+                     /usr/local/lib/libopencv_videoio.dylib \
+                     /usr/local/lib/libopencv_imgcodecs.dylib
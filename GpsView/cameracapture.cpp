@@ -0,0 +1,117 @@
+#include "cameracapture.h"
+#include "previewkernel.h"
+#include "telemetrysample.h"
+#include "videorecorder.h"
+#include "perfstats.h"
+#include "trace.h"
+
+
+CameraCapture::CameraCapture(int device, const QSize &previewSize, QObject *parent)
+    : QThread(parent),
+      deviceIndex(device),
+      maxSize(previewSize),
+      backIndex(0),
+      frontIndex(1),
+      middle(2),
+      notifyPending(0),
+      previewEnabled(1),
+      frameRateCenti(0),
+      videoRecorder(0)
+{
+    setObjectName("camera");
+    for (int i = 0; i < 3; ++i) {
+        buffers[i].timestampNs = 0;
+        buffers[i].index = 0;
+    }
+}
+
+CameraCapture::~CameraCapture()
+{
+    stop();
+}
+
+void CameraCapture::stop()
+{
+    requestInterruption();
+    wait();
+}
+
+const CameraFrame *CameraCapture::takeLatest()
+{
+    // 先重新允许通知，再取帧，取帧期间到达的新帧会再通知一次
+    notifyPending.storeRelease(0);
+
+    if (!(middle.loadAcquire() & FreshBit))
+        return 0;
+
+    frontIndex = middle.fetchAndStoreOrdered(frontIndex) & ~FreshBit;
+    return &buffers[frontIndex];
+}
+
+void CameraCapture::run()
+{
+    cv::VideoCapture cam(deviceIndex);//打开摄像头，从摄像头中获取视频
+    if (!cam.isOpened()) {
+        emit cameraError(tr("Can't open camera!"));
+        return;
+    }
+    frameRateCenti.storeRelease(qRound(cam.get(VideoCompat::PropFps) * 100));
+    // 摄像头不报告帧率时按 30 fps
+    const unsigned long framePeriodMs = frameRateCenti.loadAcquire() > 0
+            ? qMax(1, 100000 / frameRateCenti.loadAcquire()) : 33;
+
+    quint64 index = 0;
+    int badFrames = 0;
+    while (!isInterruptionRequested()) {
+        CameraFrame &out = buffers[backIndex];
+        const qint64 grabStart = Telemetry::monotonicNs();
+        cam >> out.raw;// 从摄像头中抓取并返回每一帧，尺寸不变时复用缓冲区
+        const qint64 capturedNs = Telemetry::monotonicNs();
+        const cv::Mat &frame = out.raw;
+        if (frame.empty() || frame.type() != CV_8UC3) {
+            // 摄像头拔出或出错时 cam >> 立即返回空帧，等一帧的时间再试，不空转
+            if (++badFrames >= MaxBadFrames) {
+                emit cameraError(tr("Camera stopped delivering frames"));
+                break;
+            }
+            msleep(framePeriodMs);
+            continue;
+        }
+        badFrames = 0;
+        Perf::record(Perf::CaptureTime, capturedNs - grabStart);
+        if (Trace::isEnabled())
+            Trace::record("capture", grabStart, capturedNs, index + 1);
+        Perf::add(Perf::CameraFrames);
+
+        // 录像用原始帧，和预览一样带采集时刻
+        if (videoRecorder)
+            videoRecorder->addFrame(frame, capturedNs);
+
+        if (previewEnabled.loadAcquire()) {
+            int width, height;
+            PreviewKernel::fitSize(frame.cols, frame.rows, maxSize.width(), maxSize.height(),
+                                   width, height);
+            if (out.preview.width() != width || out.preview.height() != height)
+                out.preview = QImage(width, height, QImage::Format_RGB888);
+
+            PreviewKernel::bgrToRgbArea(frame.data, frame.cols, frame.rows, int(frame.step),
+                                        out.preview.bits(), width, height, out.preview.bytesPerLine());
+            const qint64 convertedNs = Telemetry::monotonicNs();
+            Perf::record(Perf::ConvertTime, convertedNs - capturedNs);
+            if (Trace::isEnabled())
+                Trace::record("convert", capturedNs, convertedNs, index + 1);
+        } else {
+            out.preview = QImage();
+        }
+        out.timestampNs = capturedNs;
+        out.index = ++index;
+
+        // 发布到交换区，换回上一块；界面没取走的旧帧就此被丢弃
+        backIndex = middle.fetchAndStoreOrdered(backIndex | FreshBit) & ~FreshBit;
+
+        if (notifyPending.testAndSetOrdered(0, 1))
+            emit frameReady();
+    }
+
+    cam.release();//释放内存；
+}
@@ -0,0 +1,74 @@
+#ifndef CAMERACAPTURE_H
+#define CAMERACAPTURE_H
+
+#include <QThread>
+#include <QImage>
+#include <QSize>
+#include <QAtomicInt>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/opencv.hpp>
+
+// 一帧摄像头画面，缓冲区循环复用
+struct CameraFrame
+{
+    cv::Mat raw;           // 摄像头原始 BGR 帧，cam >> 直接写入
+    QImage preview;        // 缩小后的 RGB888 预览，关闭预览时为空
+    qint64 timestampNs;    // 采集时刻，Telemetry::monotonicNs() 时钟
+    quint64 index;         // 采集序号
+};
+
+// 摄像头采集线程：cam >> frame 在本线程阻塞，BGR->RGB 和缩小一次完成，
+// 结果写入三缓冲：采集线程、界面线程各占一块，中间一块交换最新帧。
+// 界面来不及取的帧直接被新帧覆盖，不会排队。
+class VideoRecorder;
+
+class CameraCapture : public QThread
+{
+    Q_OBJECT
+
+public:
+    CameraCapture(int device, const QSize &previewSize, QObject *parent = 0);
+    ~CameraCapture();
+
+    void stop();
+
+    // 是否在采集线程生成缩小的 RGB 预览；画面直接用原始帧显示时可以关掉
+    void setPreviewEnabled(bool enabled) { previewEnabled.storeRelease(enabled); }
+
+    // 在 start() 之前设置；录像时每一帧原始画面都交给它
+    void setRecorder(VideoRecorder *recorder) { videoRecorder = recorder; }
+    // 摄像头报告的帧率，打开之前为 0
+    double frameRate() const { return frameRateCenti.loadAcquire() / 100.0; }
+
+    // 界面线程调用：取最新一帧，没有新帧时返回 0。
+    // 返回的帧归界面线程所有，直到下一次调用 takeLatest()
+    const CameraFrame *takeLatest();
+
+signals:
+    void frameReady();     // 界面 takeLatest() 之前只发出一次
+    void cameraError(const QString &error);
+
+protected:
+    void run();
+
+private:
+    enum {
+        FreshBit = 0x4,
+        MaxBadFrames = 100         // 连续这么多次读不到可用的帧时报错退出
+    };
+
+    int deviceIndex;
+    QSize maxSize;
+
+    CameraFrame buffers[3];
+    int backIndex;         // 采集线程正在写的
+    int frontIndex;        // 界面线程正在显示的
+    QAtomicInt middle;     // 交换区下标，FreshBit 表示其中是界面还没取过的新帧
+    QAtomicInt notifyPending;
+    QAtomicInt previewEnabled;
+    QAtomicInt frameRateCenti;     // 帧率 x100
+    VideoRecorder *videoRecorder;
+};
+
+#endif // CAMERACAPTURE_H
@@ -0,0 +1,117 @@
+#include "coordtransform.h"
+
+#include <cmath>
+
+
+namespace {
+
+// 克拉索夫斯基椭球参数及 BD-09 的偏移常数
+const double pi = 3.1415926535897932384626;
+const double xPi = 3.14159265358979324 * 3000.0 / 180.0;
+const double a = 6378245.0;
+const double ee = 0.00669342162296594323;
+
+inline double transformLat(double x, double y)
+{
+    double ret = -100.0 + 2.0 * x + 3.0 * y + 0.2 * y * y + 0.1 * x * y + 0.2 * std::sqrt(std::fabs(x));
+    ret += (20.0 * std::sin(6.0 * x * pi) + 20.0 * std::sin(2.0 * x * pi)) * 2.0 / 3.0;
+    ret += (20.0 * std::sin(y * pi) + 40.0 * std::sin(y / 3.0 * pi)) * 2.0 / 3.0;
+    ret += (160.0 * std::sin(y / 12.0 * pi) + 320.0 * std::sin(y * pi / 30.0)) * 2.0 / 3.0;
+    return ret;
+}
+
+inline double transformLng(double x, double y)
+{
+    double ret = 300.0 + x + 2.0 * y + 0.1 * x * x + 0.1 * x * y + 0.1 * std::sqrt(std::fabs(x));
+    ret += (20.0 * std::sin(6.0 * x * pi) + 20.0 * std::sin(2.0 * x * pi)) * 2.0 / 3.0;
+    ret += (20.0 * std::sin(x * pi) + 40.0 * std::sin(x / 3.0 * pi)) * 2.0 / 3.0;
+    ret += (150.0 * std::sin(x / 12.0 * pi) + 300.0 * std::sin(x / 30.0 * pi)) * 2.0 / 3.0;
+    return ret;
+}
+
+// 以下不含境外判断，单点和批量转换共用
+inline void wgs84ToGcj02Core(double lng, double lat, double &outLng, double &outLat)
+{
+    const double radLat = lat / 180.0 * pi;
+    double magic = std::sin(radLat);
+    magic = 1.0 - ee * magic * magic;
+    const double sqrtMagic = std::sqrt(magic);
+    const double dLat = transformLat(lng - 105.0, lat - 35.0) * 180.0 / ((a * (1.0 - ee)) / (magic * sqrtMagic) * pi);
+    const double dLng = transformLng(lng - 105.0, lat - 35.0) * 180.0 / (a / sqrtMagic * std::cos(radLat) * pi);
+    outLng = lng + dLng;
+    outLat = lat + dLat;
+}
+
+inline void gcj02ToBd09Core(double lng, double lat, double &outLng, double &outLat)
+{
+    const double z = std::sqrt(lng * lng + lat * lat) + 0.00002 * std::sin(lat * xPi);
+    const double theta = std::atan2(lat, lng) + 0.000003 * std::cos(lng * xPi);
+    outLng = z * std::cos(theta) + 0.0065;
+    outLat = z * std::sin(theta) + 0.006;
+}
+
+inline void wgs84ToBd09Core(double lng, double lat, double &outLng, double &outLat)
+{
+    double gLng, gLat;
+    wgs84ToGcj02Core(lng, lat, gLng, gLat);
+    gcj02ToBd09Core(gLng, gLat, outLng, outLat);
+}
+
+} // namespace
+
+namespace CoordTransform {
+
+bool outOfChina(double lng, double lat)
+{
+    return lng < 72.004 || lng > 137.8347 || lat < 0.8293 || lat > 55.8271;
+}
+
+void wgs84ToGcj02(double lng, double lat, double &outLng, double &outLat)
+{
+    if (outOfChina(lng, lat)) {
+        outLng = lng;
+        outLat = lat;
+        return;
+    }
+    wgs84ToGcj02Core(lng, lat, outLng, outLat);
+}
+
+void gcj02ToBd09(double lng, double lat, double &outLng, double &outLat)
+{
+    gcj02ToBd09Core(lng, lat, outLng, outLat);
+}
+
+void wgs84ToBd09(double lng, double lat, double &outLng, double &outLat)
+{
+    if (outOfChina(lng, lat)) {
+        outLng = lng;
+        outLat = lat;
+        return;
+    }
+    wgs84ToBd09Core(lng, lat, outLng, outLat);
+}
+
+void wgs84ToBd09(const double *lng, const double *lat,
+                 double *outLng, double *outLat, int count)
+{
+    // 先检查整批是否都在境内（通常如此），是则省去逐点判断；
+    // 只要有一个点在境外，就逐点判断，境外的点保持原值
+    bool outside = false;
+    for (int i = 0; i < count; ++i)
+        outside |= outOfChina(lng[i], lat[i]);
+
+    if (!outside) {
+        for (int i = 0; i < count; ++i) {
+            double x, y;
+            wgs84ToBd09Core(lng[i], lat[i], x, y);
+            outLng[i] = x;
+            outLat[i] = y;
+        }
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+        wgs84ToBd09(lng[i], lat[i], outLng[i], outLat[i]);
+}
+
+} // namespace CoordTransform
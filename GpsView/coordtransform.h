@@ -0,0 +1,21 @@
+#ifndef COORDTRANSFORM_H
+#define COORDTRANSFORM_H
+
+// 本地完成 WGS-84 -> GCJ-02 -> BD-09 坐标转换，代替百度的远程转换接口。
+// 经纬度单位为度；中国境外的点不做偏移，原样返回
+namespace CoordTransform {
+
+bool outOfChina(double lng, double lat);
+
+void wgs84ToGcj02(double lng, double lat, double &outLng, double &outLat);
+void gcj02ToBd09(double lng, double lat, double &outLng, double &outLat);
+void wgs84ToBd09(double lng, double lat, double &outLng, double &outLat);
+
+// 批量转换 count 个点，数组按经度、纬度分开存放；省的是逐点调用和打包的开销，
+// 其中的 sin/cos/atan2 编译器不会向量化。输出可以与输入是同一数组
+void wgs84ToBd09(const double *lng, const double *lat,
+                 double *outLng, double *outLat, int count);
+
+} // namespace CoordTransform
+
+#endif // COORDTRANSFORM_H
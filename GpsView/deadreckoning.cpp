@@ -0,0 +1,125 @@
+#include "deadreckoning.h"
+
+#include <math.h>
+
+namespace {
+
+const double MetersPerDegree = 6378137.0 * M_PI / 180.0;
+
+// 角度差归一化到 (-180, 180]
+double wrapDegrees(double degrees)
+{
+    degrees = fmod(degrees, 360.0);
+    if (degrees > 180.0)
+        degrees -= 360.0;
+    else if (degrees <= -180.0)
+        degrees += 360.0;
+    return degrees;
+}
+
+} // namespace
+
+
+DeadReckoning::DeadReckoning()
+{
+    reset();
+}
+
+void DeadReckoning::reset()
+{
+    valid = false;
+    originLat = originLng = 0.0;
+    metersPerDegreeLng = MetersPerDegree;
+    fixNs = correctionNs = 0;
+    fix.north = fix.east = fix.up = 0.0;
+    velocity = offset = fix;
+    yaw = yawOffset = 0.0;
+    linkDelay = -1;
+}
+
+DeadReckoning::Vector DeadReckoning::predict(qint64 nowNs) const
+{
+    const double dt = qBound<qint64>(0, nowNs - fixNs, qint64(MaxExtrapolationMs) * 1000000) * 1e-9;
+    const double decay = exp(-(nowNs - correctionNs) * 1e-6 / CorrectionMs);
+
+    Vector p;
+    p.north = fix.north + velocity.north * dt + offset.north * decay;
+    p.east  = fix.east  + velocity.east  * dt + offset.east  * decay;
+    p.up    = fix.up    + velocity.up    * dt + offset.up    * decay;
+    return p;
+}
+
+void DeadReckoning::addFix(const TelemetrySample &sample, qint64 nowNs, qint64 wallMs)
+{
+    // 发出到收到的时间 = 收到时的 Unix 时间 - 发送时刻；类似 TCP 的 RTT，第一次直接取值，之后 1/8 平滑
+    qint64 delay = 0;
+    if (sample.sentMs > 0) {
+        const qint64 measured = qBound<qint64>(0, Telemetry::linkDelayNs(sample, nowNs, wallMs),
+                                               qint64(MaxLinkDelayMs) * 1000000);
+        linkDelay = linkDelay < 0 ? measured : linkDelay + (measured - linkDelay) / 8;
+        delay = linkDelay;
+    }
+    const qint64 measuredNs = sample.timestampNs - delay;
+
+    if (!valid) {
+        originLat = sample.latitude;
+        originLng = sample.longitude;
+        metersPerDegreeLng = MetersPerDegree * cos(originLat * M_PI / 180.0);
+    }
+
+    Vector next;
+    next.north = (sample.latitude - originLat) * MetersPerDegree;
+    next.east  = (sample.longitude - originLng) * metersPerDegreeLng;
+    next.up    = sample.altitude;
+
+    // 当前显示的位置，新状态从这里平滑过渡过去
+    const Vector shown = predict(nowNs);
+    const double shownYaw = yaw + yawOffset * exp(-(nowNs - correctionNs) * 1e-6 / CorrectionMs);
+    const bool smooth = valid
+            && nowNs - fixNs < qint64(ResetGapMs) * 1000000
+            && hypot(shown.north - next.north, shown.east - next.east) < ResetDistance;
+
+    valid = true;
+    fixNs = measuredNs;
+    fix = next;
+    // 遥测速度为 DJI MSDK 的 NED：X 北、Y 东、Z 向下
+    velocity.north = sample.velocityX;
+    velocity.east  = sample.velocityY;
+    velocity.up    = -sample.velocityZ;
+    yaw = sample.yaw;
+
+    correctionNs = nowNs;
+    offset.north = offset.east = offset.up = 0.0;
+    yawOffset = 0.0;
+    if (smooth) {
+        const Vector target = predict(nowNs);
+        offset.north = shown.north - target.north;
+        offset.east  = shown.east  - target.east;
+        offset.up    = shown.up    - target.up;
+        yawOffset = wrapDegrees(shownYaw - yaw);
+    }
+}
+
+bool DeadReckoning::position(qint64 nowNs, double &lng, double &lat, double &alt, double &heading) const
+{
+    if (!valid)
+        return false;
+
+    const Vector p = predict(nowNs);
+    lat = originLat + p.north / MetersPerDegree;
+    lng = originLng + p.east / metersPerDegreeLng;
+    alt = p.up;
+    heading = wrapDegrees(yaw + yawOffset * exp(-(nowNs - correctionNs) * 1e-6 / CorrectionMs));
+    return true;
+}
+
+bool DeadReckoning::isMoving(qint64 nowNs) const
+{
+    if (!valid)
+        return false;
+
+    // 修正在 5 个时间常数后可以忽略
+    const bool correcting = nowNs - correctionNs < qint64(CorrectionMs) * 5 * 1000000;
+    const bool moving = velocity.north != 0.0 || velocity.east != 0.0 || velocity.up != 0.0;
+    return correcting || (moving && nowNs - fixNs < qint64(MaxExtrapolationMs) * 1000000);
+}
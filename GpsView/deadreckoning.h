@@ -0,0 +1,65 @@
+#ifndef DEADRECKONING_H
+#define DEADRECKONING_H
+
+#include "telemetrysample.h"
+
+// 两次定位之间按匀速外推位置，让标记和读数以屏幕刷新率平滑移动。
+// 速度直接用遥测中的 velocityX/Y/Z，所以不需要滤波器去估计速度；
+// 新定位到来时位置立即改为新值，显示上的差值按指数衰减掉，标记不会跳。
+// 报文带发送时刻时扣除链路延迟：定位视为在发出时测得，外推到当前时刻。
+// 在以第一个定位为原点的局部平面（北、东、上，米）中计算。
+class DeadReckoning
+{
+public:
+    enum {
+        MaxExtrapolationMs = 2000,  // 超过这么久没有新定位就停在外推到的位置
+        MaxLinkDelayMs = 1000,      // 估计的链路延迟上限，超出多半是两端时钟不同步
+        ResetDistance = 100,        // 米，新定位偏离预测太远时不做平滑，直接跳过去
+        ResetGapMs = 5000,
+        CorrectionMs = 250          // 误差衰减的时间常数
+    };
+
+    DeadReckoning();
+
+    void reset();
+    bool isValid() const { return valid; }
+
+    // nowNs 为 monotonicNs()，wallMs 为同一时刻的 Unix 时间，用于计算链路延迟
+    void addFix(const TelemetrySample &sample, qint64 nowNs, qint64 wallMs);
+
+    // 外推到 nowNs 的位置（WGS-84）和航向；还没有定位时返回 false
+    bool position(qint64 nowNs, double &lng, double &lat, double &alt, double &heading) const;
+
+    // 还在外推或修正中，需要继续按刷新率取位置
+    bool isMoving(qint64 nowNs) const;
+
+    qint64 linkDelayNs() const { return qMax<qint64>(0, linkDelay); }
+
+private:
+    struct Vector
+    {
+        double north;
+        double east;
+        double up;
+    };
+
+    Vector predict(qint64 nowNs) const;
+
+    bool valid;
+    double originLat;
+    double originLng;
+    double metersPerDegreeLng;
+
+    qint64 fixNs;           // 定位的测量时刻（已扣除链路延迟）
+    Vector fix;             // 定位位置
+    Vector velocity;        // m/s
+    double yaw;
+
+    qint64 correctionNs;    // 开始修正的时刻
+    Vector offset;          // 修正开始时显示位置与新外推位置之差
+    double yawOffset;
+
+    qint64 linkDelay;       // 平滑后的链路延迟，还没测到时为 -1
+};
+
+#endif // DEADRECKONING_H
@@ -0,0 +1,117 @@
+#include "dronesession.h"
+#include "perfstats.h"
+#include "trace.h"
+
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QtEndian>
+
+
+DroneSession::DroneSession(QTcpSocket *socket, QObject *parent)
+    : QObject(parent),
+      sample(),
+      tcpSocket(socket),
+      wireProtocol(UnknownProtocol),
+      stats(),
+      hasSequence(false),
+      lastSequence(0),
+      acceptedNs(0)
+{
+    tcpSocket->setParent(this);
+    droneId = QString("%1:%2").arg(socket->peerAddress().toString())
+                              .arg(socket->peerPort());
+    droneIdUtf8 = droneId.toUtf8();
+
+    connect(tcpSocket, &QTcpSocket::readyRead, this, &DroneSession::readFrames);
+    connect(tcpSocket, &QTcpSocket::disconnected, this, [this]() {
+        emit disconnected(this);
+    });
+}
+
+DroneSession::DroneSession(const QString &peer, QObject *parent)
+    : QObject(parent),
+      sample(),
+      tcpSocket(0),
+      droneId(peer),
+      droneIdUtf8(peer.toUtf8()),
+      wireProtocol(UnknownProtocol),
+      stats(),
+      hasSequence(false),
+      lastSequence(0),
+      acceptedNs(0)
+{
+}
+
+void DroneSession::abort()
+{
+    if (!tcpSocket)
+        return;
+    tcpSocket->disconnect(this);
+    tcpSocket->abort();
+}
+
+bool DroneSession::acceptSequence(quint32 sequence, qint64 nowNs)
+{
+    // 按差值判断先后，序号回绕后依然成立
+    const qint32 delta = qint32(sequence - lastSequence);
+    const bool restarted = !hasSequence || delta <= -SequenceWindow
+            || nowNs - acceptedNs > qint64(ResyncMs) * 1000000;
+
+    if (restarted) {
+        hasSequence = true;
+        missing.reset();
+    } else if (delta == 0) {
+        stats.duplicates++;
+        return false;
+    } else if (delta < 0) {
+        // 之前按丢包计过，现在迟到了：改记为乱序，但旧数据不再使用；不在缺口中的是重复包
+        const int bit = int(sequence % SequenceWindow);
+        if (!missing.test(bit)) {
+            stats.duplicates++;
+            return false;
+        }
+        missing.reset(bit);
+        stats.lost--;
+        stats.reordered++;
+        return false;
+    } else if (delta > SequenceWindow) {
+        stats.lost += quint32(delta - 1);
+        missing.set();
+    } else {
+        stats.lost += quint32(delta - 1);
+        for (quint32 s = lastSequence + 1; s != sequence; ++s)
+            missing.set(s % SequenceWindow);
+    }
+
+    missing.reset(sequence % SequenceWindow);
+    stats.received++;
+    lastSequence = sequence;
+    acceptedNs = nowNs;
+    return true;
+}
+
+void DroneSession::readFrames()
+{
+    Trace::Span span("socket read");
+    const int before = inBlock.size();
+    inBlock.append(tcpSocket->readAll());
+    Perf::add(Perf::BytesReceived, quint64(inBlock.size() - before));
+
+    // 帧格式与 Java writeUTF 一致：2 字节大端长度 + UTF-8 数据。
+    // TCP 会合并/拆分数据包，一次 readyRead 可能带来多帧或半帧，逐帧取出
+    int offset = 0;
+    while (inBlock.size() - offset >= 2) {
+        const uchar *head = reinterpret_cast<const uchar *>(inBlock.constData()) + offset;
+        const int frameLen = qFromBigEndian<quint16>(head);
+        if (inBlock.size() - offset - 2 < frameLen)
+            break;      // 半帧，等待后续数据
+
+        stats.received++;
+        emit frameReceived(this, QByteArray::fromRawData(inBlock.constData() + offset + 2, frameLen));
+        offset += 2 + frameLen;
+    }
+
+    // 只移除已处理的完整帧，剩下的半帧留在缓冲区中
+    if (offset > 0)
+        inBlock.remove(0, offset);
+}
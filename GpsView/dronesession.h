@@ -0,0 +1,77 @@
+#ifndef DRONESESSION_H
+#define DRONESESSION_H
+
+#include <QObject>
+#include <QByteArray>
+
+#include <bitset>
+
+#include "telemetrysample.h"
+
+class QTcpSocket;
+
+// 链路统计。TCP 只统计 received，UDP 按数据包序号统计丢包和乱序
+struct LinkStats
+{
+    quint64 received;
+    quint64 lost;          // 序号跳过的包（之后在窗口内迟到的会再减掉）
+    quint64 reordered;     // 迟到的旧包，按“只要最新”丢弃
+    quint64 duplicates;
+};
+
+// 一架飞机的连接：TCP 连接负责拆帧；UDP 没有连接，按发送端地址建会话。
+// 同时保存该飞机最近一次的遥测数据
+class DroneSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 报文格式在收到第一帧时确定，之后整个连接保持不变
+    enum Protocol { UnknownProtocol, JsonProtocol, BinaryProtocol };
+
+    enum {
+        SequenceWindow = 1024,      // 记录最近这么多个序号是否收到；更早的包视为发送端重启
+        ResyncMs = 3000             // 这么久没有收到新包后，下一个包直接作为新起点
+    };
+
+    DroneSession(QTcpSocket *socket, QObject *parent = 0);
+    DroneSession(const QString &peer, QObject *parent = 0);     // UDP
+
+    QString id() const { return droneId; }
+    void setId(const QString &id) { droneId = id; droneIdUtf8 = id.toUtf8(); }
+    const QByteArray &idUtf8() const { return droneIdUtf8; }
+    QTcpSocket *socket() const { return tcpSocket; }
+    Protocol protocol() const { return wireProtocol; }
+    void setProtocol(Protocol protocol) { wireProtocol = protocol; }
+    void abort();
+
+    // UDP 数据包序号检查：只接受比已收到的都新的包。
+    // 序号大幅后退或长时间没有新包时按发送端重启处理，重新开始计数
+    bool acceptSequence(quint32 sequence, qint64 nowNs);
+    const LinkStats &linkStats() const { return stats; }
+    qint64 lastAcceptedNs() const { return acceptedNs; }
+
+    TelemetrySample sample;    // 该飞机最近一次的遥测状态
+
+signals:
+    // frame 直接引用接收缓冲区，只在本次调用期间有效
+    void frameReceived(DroneSession *session, const QByteArray &frame);
+    void disconnected(DroneSession *session);
+
+private:
+    void readFrames();
+
+    QTcpSocket *tcpSocket;
+    QString droneId;       // 未收到 DroneID 之前为 "地址:端口"
+    QByteArray droneIdUtf8;    // 记录飞行数据时使用，避免每帧转换
+    Protocol wireProtocol;
+    QByteArray inBlock;    // 数据缓冲区，保存尚未收完的半帧
+
+    LinkStats stats;
+    bool hasSequence;
+    quint32 lastSequence;
+    qint64 acceptedNs;     // 上一次接受新包的 monotonicNs()
+    std::bitset<SequenceWindow> missing;   // 按 序号 % SequenceWindow，计入 lost 还没到的包
+};
+
+#endif // DRONESESSION_H
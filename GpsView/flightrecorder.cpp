@@ -0,0 +1,146 @@
+#include "flightrecorder.h"
+#include "perfstats.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QtEndian>
+
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+FlightRecorder::FlightRecorder(QObject *parent)
+    : QThread(parent)
+{
+    setObjectName("flight recorder");
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    stopRecording();
+}
+
+bool FlightRecorder::startRecording(const QString &fileName)
+{
+    stopRecording();
+
+    // 上一次停止时接收线程可能还放进了几条，丢掉
+    Record stale;
+    while (queue.pop(stale)) {
+    }
+    dropped.storeRelease(0);
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered))
+        return false;
+
+    char header[FileHeaderSize];
+    memcpy(header, "GVFR", 4);
+    qToLittleEndian<quint32>(Version, reinterpret_cast<uchar *>(header + 4));
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), reinterpret_cast<uchar *>(header + 8));
+    qToLittleEndian<qint64>(Telemetry::monotonicNs(), reinterpret_cast<uchar *>(header + 16));
+    if (file.write(header, FileHeaderSize) != FileHeaderSize) {
+        file.close();
+        return false;
+    }
+
+    recording.storeRelease(1);
+    start(QThread::LowPriority);
+    return true;
+}
+
+void FlightRecorder::stopRecording()
+{
+    recording.storeRelease(0);
+    if (isRunning()) {
+        requestInterruption();
+        wait();
+    }
+    if (file.isOpen())
+        file.close();
+}
+
+void FlightRecorder::record(const TelemetrySample &sample, qint64 receivedNs, const QByteArray &droneId)
+{
+    if (!recording.loadAcquire())
+        return;
+
+    Record r;
+    r.timestampNs = receivedNs;
+    r.sentMs = qint64(sample.sentMs);
+    r.length = quint16(TelemetryBinary::encode(sample, sample.sections, quint32(sample.sequence),
+                                               droneId.constData(),
+                                               qMin(droneId.size(), int(TelemetryBinary::MaxDroneIdLength)),
+                                               r.frame, sizeof(r.frame)));
+    if (!r.length || !queue.push(r)) {
+        dropped.fetchAndAddRelaxed(1);
+        Perf::add(Perf::RecordsDropped);
+    }
+}
+
+void FlightRecorder::run()
+{
+    QByteArray buffer;
+    buffer.reserve(64 * 1024);
+    QElapsedTimer sinceSync;
+    sinceSync.start();
+    bool unsynced = false;
+
+    // 停止时先把队列写完再退出
+    bool stopping = false;
+    while (!stopping) {
+        stopping = isInterruptionRequested();
+
+        if (!writeRecords(buffer)) {
+            recording.storeRelease(0);
+            emit recordingFailed(file.errorString());
+            break;
+        }
+        unsynced = unsynced || !buffer.isEmpty();
+        buffer.resize(0);      // 保留已分配的空间，clear() 会释放
+
+        // 攒一段时间再 fsync，每条都同步的话磁盘跟不上几百 Hz
+        if (unsynced && (stopping || sinceSync.elapsed() >= SyncInterval)) {
+            sync();
+            unsynced = false;
+            sinceSync.restart();
+        }
+
+        if (!stopping)
+            msleep(WriteInterval);
+    }
+}
+
+// 取出队列中的全部记录，一次写入
+bool FlightRecorder::writeRecords(QByteArray &buffer)
+{
+    Record r;
+    while (queue.pop(r)) {
+        char header[RecordHeaderSize];
+        qToLittleEndian<quint16>(r.length, reinterpret_cast<uchar *>(header));
+        qToLittleEndian<qint64>(r.timestampNs, reinterpret_cast<uchar *>(header + 2));
+        qToLittleEndian<qint64>(r.sentMs, reinterpret_cast<uchar *>(header + 10));
+        buffer.append(header, RecordHeaderSize);
+        buffer.append(r.frame, r.length);
+    }
+
+    if (buffer.isEmpty())
+        return true;
+    return file.write(buffer) == buffer.size();
+}
+
+void FlightRecorder::sync()
+{
+#if defined(Q_OS_WIN)
+    _commit(file.handle());
+#elif defined(Q_OS_LINUX)
+    ::fdatasync(file.handle());
+#else
+    ::fsync(file.handle());
+#endif
+}
@@ -0,0 +1,71 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QThread>
+#include <QFile>
+#include <QAtomicInt>
+
+#include "spscqueue.h"
+#include "telemetrysample.h"
+#include "telemetrybinary.h"
+
+// 飞行记录：把收到的每一条遥测（所有飞机）追加写入二进制文件。
+// 接收线程只把编码好的记录放进无锁队列，写文件和 fsync 都在记录线程中，
+// 磁盘再慢也不会阻塞接收和界面；队列满时丢弃并计数。
+//
+// 文件格式（小端）：
+//   文件头 24 字节：char[4] "GVFR", u32 版本, i64 开始时的 ms since epoch,
+//                   i64 同一时刻的 Telemetry::monotonicNs()
+//   之后为连续的记录：u16 帧长度 n, i64 接收时刻 monotonicNs,
+//                     i64 发送端时刻 Unix ms（报文没有时为 0）, n 字节 TelemetryBinary 帧
+class FlightRecorder : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum {
+        Version = 1,
+        FileHeaderSize = 24,
+        RecordHeaderSize = 18,
+        WriteInterval = 20,        // ms，每次把队列中的记录一起写入
+        SyncInterval = 500         // ms，两次 fsync 之间的最长间隔
+    };
+
+    explicit FlightRecorder(QObject *parent = 0);
+    ~FlightRecorder();
+
+    // 以下在界面线程调用
+    bool startRecording(const QString &fileName);
+    void stopRecording();
+    bool isRecording() const { return recording.loadAcquire(); }
+    QString errorString() const { return file.errorString(); }
+    quint64 droppedRecords() const { return quint64(dropped.loadAcquire()); }
+
+    // 只能在接收线程调用；未在记录时直接返回
+    void record(const TelemetrySample &sample, qint64 receivedNs, const QByteArray &droneId);
+
+signals:
+    void recordingFailed(const QString &error);    // 写文件出错，记录已停止
+
+protected:
+    void run();
+
+private:
+    struct Record
+    {
+        qint64 timestampNs;
+        qint64 sentMs;
+        quint16 length;
+        char frame[TelemetryBinary::MaxFrameSize];
+    };
+
+    bool writeRecords(QByteArray &buffer);
+    void sync();
+
+    QFile file;
+    SpscQueue<Record, 8192> queue;
+    QAtomicInt recording;
+    QAtomicInt dropped;
+};
+
+#endif // FLIGHTRECORDER_H
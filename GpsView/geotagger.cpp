@@ -0,0 +1,243 @@
+#include "geotagger.h"
+#include "videorecorder.h"
+#include "perfstats.h"
+#include "trace.h"
+
+#include <QDir>
+#include <QDateTime>
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+#include <vector>
+#include <math.h>
+
+
+namespace {
+
+const double MetersPerDegree = 6378137.0 * M_PI / 180.0;
+
+double interpolateDegrees(double a, double b, double t)
+{
+    double delta = fmod(b - a, 360.0);
+    if (delta > 180.0)
+        delta -= 360.0;
+    else if (delta < -180.0)
+        delta += 360.0;
+    return a + delta * t;
+}
+
+// 在线程池中编码并写一帧
+class JpegWriter : public QRunnable
+{
+public:
+    JpegWriter(const cv::Mat &image, const QString &fileName, QAtomicInt *queued, QAtomicInt *failed)
+        : image(image), fileName(fileName.toStdString()), queued(queued), failed(failed) {}
+
+    void run()
+    {
+        Trace::Span span("write keyframe");
+        std::vector<int> params;
+        params.push_back(VideoCompat::JpegQuality);
+        params.push_back(GeoTagger::JpegQuality);
+        if (!cv::imwrite(fileName, image, params))
+            failed->ref();
+        queued->deref();
+    }
+
+private:
+    cv::Mat image;
+    std::string fileName;
+    QAtomicInt *queued;
+    QAtomicInt *failed;
+};
+
+} // namespace
+
+
+GeoTagger::GeoTagger(QObject *parent)
+    : QObject(parent),
+      capturing(false),
+      fieldOfView(70.0),
+      overlap(0.7),
+      hasLastKey(false),
+      keyframes(0)
+{
+    // 留出核心给采集、网络和界面
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 2));
+    history.reserve(HistorySize * 2);
+}
+
+GeoTagger::~GeoTagger()
+{
+    stop();
+}
+
+bool GeoTagger::start(const QString &directory)
+{
+    stop();
+
+    imageDir = directory + "/images";
+    priorsFile.setFileName(directory + "/priors.txt");
+    posesFile.setFileName(directory + "/poses.csv");
+    if (!QDir().mkpath(imageDir)
+            || !priorsFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)
+            || !posesFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        priorsFile.close();
+        emit captureFailed(tr("Can't create %1").arg(directory));
+        return false;
+    }
+    priorsFile.write("# image_name latitude longitude relative_altitude (height above takeoff, not ellipsoidal)\n");
+    posesFile.write("image,time_ns,latitude,longitude,relative_altitude,yaw,gimbal_pitch,gimbal_roll,gimbal_yaw\n");
+
+    keyframes = 0;
+    hasLastKey = false;
+    failedWrites.storeRelease(0);
+    capturing = true;
+    return true;
+}
+
+void GeoTagger::stop()
+{
+    if (!capturing)
+        return;
+
+    // 还在等遥测的帧用已有的遥测写出
+    resolvePending(true);
+    capturing = false;
+    pool.waitForDone();
+    priorsFile.close();
+    posesFile.close();
+
+    const int failed = failedWrites.loadAcquire();
+    if (failed)
+        emit captureFailed(tr("%1 keyframes couldn't be written to %2").arg(failed).arg(imageDir));
+}
+
+void GeoTagger::addSample(const TelemetrySample &sample)
+{
+    if (!(sample.sections & TelemetrySample::GPS))
+        return;
+
+    // 位置按飞机发出的时刻记，链路延迟不可信（两端时钟不同步）时按收到的时刻
+    const qint64 delay = Telemetry::linkDelayNs(sample, Telemetry::monotonicNs(),
+                                                QDateTime::currentMSecsSinceEpoch());
+    Pose pose;
+    pose.timeNs = sample.timestampNs - qBound<qint64>(0, delay, qint64(MaxWaitMs) * 1000000);
+    pose.latitude = sample.latitude;
+    pose.longitude = sample.longitude;
+    pose.altitude = sample.altitude;
+    pose.yaw = sample.yaw;
+    pose.gimbalPitch = sample.gimbalPitch;
+    pose.gimbalRoll = sample.gimbalRoll;
+    pose.gimbalYaw = sample.gimbalYaw;
+    if (!history.isEmpty() && pose.timeNs <= history.last().timeNs)
+        return;
+
+    // 攒满两倍后一次丢掉前一半，避免每次都搬动
+    if (history.size() >= HistorySize * 2)
+        history.remove(0, HistorySize);
+    history.append(pose);
+
+    if (capturing)
+        resolvePending(false);
+}
+
+void GeoTagger::offerFrame(const cv::Mat &frame, qint64 timestampNs)
+{
+    if (!capturing || frame.empty())
+        return;
+    resolvePending(false);
+
+    Pose pose;
+    if (!poseAt(timestampNs, pose))
+        return;
+
+    // 间距取画面地面覆盖宽度中不重叠的部分；高度为相对起飞点的高度
+    if (hasLastKey) {
+        const double north = (pose.latitude - lastKey.latitude) * MetersPerDegree;
+        const double east = (pose.longitude - lastKey.longitude) * MetersPerDegree
+                * cos(pose.latitude * M_PI / 180.0);
+        const double footprint = 2.0 * qMax(0.0, pose.altitude) * tan(fieldOfView * M_PI / 360.0);
+        if (hypot(north, east) < qMax<double>(MinSpacing, footprint * (1.0 - overlap)))
+            return;
+    }
+
+    if (pending.size() >= MaxPending || queued.loadAcquire() >= MaxQueued) {
+        Perf::add(Perf::KeyframesDropped);
+        return;
+    }
+
+    Trace::Span span("copy keyframe");
+    Pending key;
+    key.image = frame.clone();
+    key.timeNs = timestampNs;
+    pending.append(key);
+    lastKey = pose;
+    hasLastKey = true;
+}
+
+bool GeoTagger::poseAt(qint64 timeNs, Pose &pose) const
+{
+    if (history.isEmpty() || timeNs < history.first().timeNs)
+        return false;
+
+    const Pose &last = history.last();
+    if (timeNs >= last.timeNs) {
+        pose = last;
+        pose.timeNs = timeNs;
+        return true;
+    }
+
+    // 第一个晚于 timeNs 的遥测和它前一个之间线性插值
+    const Pose *after = std::upper_bound(history.constBegin(), history.constEnd(), timeNs,
+                                         [](qint64 t, const Pose &p) { return t < p.timeNs; });
+    const Pose &a = *(after - 1);
+    const Pose &b = *after;
+    const double t = double(timeNs - a.timeNs) / double(b.timeNs - a.timeNs);
+
+    pose.timeNs = timeNs;
+    pose.latitude = a.latitude + (b.latitude - a.latitude) * t;
+    pose.longitude = a.longitude + (b.longitude - a.longitude) * t;
+    pose.altitude = a.altitude + (b.altitude - a.altitude) * t;
+    pose.yaw = interpolateDegrees(a.yaw, b.yaw, t);
+    pose.gimbalPitch = a.gimbalPitch + (b.gimbalPitch - a.gimbalPitch) * t;
+    pose.gimbalRoll = a.gimbalRoll + (b.gimbalRoll - a.gimbalRoll) * t;
+    pose.gimbalYaw = interpolateDegrees(a.gimbalYaw, b.gimbalYaw, t);
+    return true;
+}
+
+// 遥测已经覆盖到帧的时刻、等得太久或 force 时写出
+void GeoTagger::resolvePending(bool force)
+{
+    const qint64 newest = history.isEmpty() ? 0 : history.last().timeNs;
+    const qint64 deadline = Telemetry::monotonicNs() - qint64(MaxWaitMs) * 1000000;
+
+    while (!pending.isEmpty()) {
+        const Pending &frame = pending.first();
+        if (!force && frame.timeNs > newest && frame.timeNs > deadline)
+            break;
+
+        Pose pose;
+        if (poseAt(frame.timeNs, pose))
+            writeKeyframe(frame, pose);
+        pending.removeFirst();
+    }
+}
+
+void GeoTagger::writeKeyframe(const Pending &frame, const Pose &pose)
+{
+    const QString name = QString("%1.jpg").arg(++keyframes, 6, 10, QChar('0'));
+
+    priorsFile.write(QString("%1 %2 %3 %4\n").arg(name)
+                     .arg(pose.latitude, 0, 'f', 9).arg(pose.longitude, 0, 'f', 9)
+                     .arg(pose.altitude, 0, 'f', 3).toLatin1());
+    posesFile.write(QString("%1,%2,%3,%4,%5,%6,%7,%8,%9\n").arg(name).arg(pose.timeNs)
+                    .arg(pose.latitude, 0, 'f', 9).arg(pose.longitude, 0, 'f', 9)
+                    .arg(pose.altitude, 0, 'f', 3).arg(pose.yaw, 0, 'f', 2)
+                    .arg(pose.gimbalPitch, 0, 'f', 2).arg(pose.gimbalRoll, 0, 'f', 2)
+                    .arg(pose.gimbalYaw, 0, 'f', 2).toLatin1());
+
+    queued.ref();
+    pool.start(new JpegWriter(frame.image, imageDir + "/" + name, &queued, &failedWrites));
+}
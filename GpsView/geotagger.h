@@ -0,0 +1,104 @@
+#ifndef GEOTAGGER_H
+#define GEOTAGGER_H
+
+#include <QObject>
+#include <QVector>
+#include <QList>
+#include <QFile>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+#include <opencv2/opencv.hpp>
+
+#include "telemetrysample.h"
+
+// 航拍建模用的关键帧：按飞过的距离和期望的重叠率从实时画面中挑帧，
+// 把遥测插值到帧的采集时刻得到位置和姿态，输出一组 JPEG 和位置先验，
+// 供 COLMAP 的 spatial_matcher 使用（导入见 tools/colmap_import_priors.py）。
+//
+// 帧的采集时刻往往比覆盖它的遥测先到，所以选中的帧先复制下来等待，
+// 收到时刻不早于它的遥测后再插值；JPEG 编码和写文件在线程池中完成，
+// 界面线程只做选帧和一次内存复制。
+//
+// 输出目录：
+//   images/000001.jpg ...
+//   priors.txt   每行 "图像名 纬度 经度 相对高度"，经纬度为 WGS-84，
+//                高度是飞控报告的相对起飞点高度（不是椭球高），即 COLMAP 的 GPS 先验
+//   poses.csv    图像名、采集时刻和插值得到的机头、云台姿态
+class GeoTagger : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum {
+        HistorySize = 1024,     // 保留的遥测条数，至少覆盖几秒
+        MaxPending = 8,         // 等待遥测的帧
+        MaxQueued = 16,         // 线程池中未写完的 JPEG，超出时跳过这一帧
+        MaxWaitMs = 1000,       // 遥测迟迟不到时用最近一条
+        MinSpacing = 1,         // 米，相邻关键帧的最小间距
+        JpegQuality = 95
+    };
+
+    explicit GeoTagger(QObject *parent = 0);
+    ~GeoTagger();
+
+    // 相机水平视场角和相邻关键帧的重叠率，决定关键帧间距
+    void setFieldOfView(double degrees) { fieldOfView = degrees; }
+    void setOverlap(double fraction) { overlap = qBound(0.0, fraction, 0.95); }
+
+    // 以下都在界面线程调用
+    bool start(const QString &directory);
+    void stop();
+    bool isCapturing() const { return capturing; }
+    int keyframeCount() const { return keyframes; }
+
+    void addSample(const TelemetrySample &sample);
+    // 每显示一帧调用一次；不是关键帧时几乎没有开销
+    void offerFrame(const cv::Mat &frame, qint64 timestampNs);
+
+signals:
+    void captureFailed(const QString &error);
+
+private:
+    struct Pose
+    {
+        qint64 timeNs;
+        double latitude;
+        double longitude;
+        double altitude;        // 相对起飞点
+        double yaw;
+        double gimbalPitch;
+        double gimbalRoll;
+        double gimbalYaw;
+    };
+
+    struct Pending
+    {
+        cv::Mat image;
+        qint64 timeNs;
+    };
+
+    // timeNs 之后还没有遥测时返回最近一条；比保留的遥测都早时返回 false
+    bool poseAt(qint64 timeNs, Pose &pose) const;
+    void resolvePending(bool force);
+    void writeKeyframe(const Pending &frame, const Pose &pose);
+
+    bool capturing;
+    double fieldOfView;
+    double overlap;
+
+    QVector<Pose> history;         // 按时间顺序
+    QList<Pending> pending;
+    bool hasLastKey;
+    Pose lastKey;                  // 上一个关键帧的位置（选帧时的估计）
+
+    QString imageDir;
+    QFile priorsFile;
+    QFile posesFile;
+    int keyframes;
+    QThreadPool pool;
+    QAtomicInt queued;
+    QAtomicInt failedWrites;
+};
+
+#endif // GEOTAGGER_H
@@ -0,0 +1,4 @@
+#include "logging.h"
+
+Q_LOGGING_CATEGORY(lcIngest, "gpsview.ingest", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcUi, "gpsview.ui", QtInfoMsg)
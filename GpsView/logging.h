@@ -0,0 +1,12 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QLoggingCategory>
+
+// 日志分类。调试级别默认关闭，关闭时 qCDebug 只有一次判断，报文不会被格式化；
+// 运行时用 QT_LOGGING_RULES="gpsview.*.debug=true" 打开，
+// 编译时定义 QT_NO_DEBUG_OUTPUT 可完全去掉
+Q_DECLARE_LOGGING_CATEGORY(lcIngest)
+Q_DECLARE_LOGGING_CATEGORY(lcUi)
+
+#endif // LOGGING_H
@@ -0,0 +1,85 @@
+#include "logmodel.h"
+
+#include <QDateTime>
+
+
+LogModel::LogModel(int capacity, int refreshRate, QObject *parent)
+    : QAbstractListModel(parent),
+      entries(qMax(1, capacity)),
+      head(0),
+      count(0),
+      pendingHead(0)
+{
+    pending.reserve(entries.size());
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(1000 / qMax(1, refreshRate));
+    connect(&flushTimer, &QTimer::timeout, this, &LogModel::flush);
+}
+
+void LogModel::append(qint64 timeMs, const QString &text)
+{
+    Entry entry = { timeMs, text };
+
+    // 一个刷新周期内来得比容量还多时，最旧的根本不会显示，直接覆盖
+    if (pending.size() == entries.size()) {
+        pending[pendingHead] = entry;
+        pendingHead = (pendingHead + 1) % pending.size();
+    } else {
+        pending.append(entry);
+    }
+    if (!flushTimer.isActive())
+        flushTimer.start();
+}
+
+void LogModel::clear()
+{
+    beginResetModel();
+    for (int i = 0; i < count; ++i)
+        entries[(head + i) % entries.size()].text.clear();
+    head = 0;
+    count = 0;
+    pending.resize(0);
+    pendingHead = 0;
+    endResetModel();
+}
+
+void LogModel::flush()
+{
+    if (pending.isEmpty())
+        return;
+
+    const int capacity = entries.size();
+
+    // 先把要被覆盖的最旧条目移出，再一次性插入整批
+    const int overflow = count + pending.size() - capacity;
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        head = (head + overflow) % capacity;
+        count -= overflow;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), count, count + pending.size() - 1);
+    for (int i = 0; i < pending.size(); ++i)
+        entries[(head + count + i) % capacity] = pending[(pendingHead + i) % pending.size()];
+    count += pending.size();
+    endInsertRows();
+
+    pending.resize(0);      // 保留容量，下一批不再分配
+    pendingHead = 0;
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : count;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= count)
+        return QVariant();
+
+    // 时间只在行可见时才格式化
+    const Entry &entry = entries[(head + index.row()) % entries.size()];
+    return QDateTime::fromMSecsSinceEpoch(entry.timeMs).toString("[ hh:mm:ss ] ") + entry.text;
+}
@@ -0,0 +1,41 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QTimer>
+
+// 固定容量的日志模型：环形缓冲区保存最近 capacity 条，超出后覆盖最旧的。
+// append() 只把条目放进待写队列，由定时器按上限频率批量插入，
+// 配合 QListView 只绘制可见行，整次飞行内存和单条开销都保持不变。
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit LogModel(int capacity = 5000, int refreshRate = 10, QObject *parent = 0);
+
+    void append(qint64 timeMs, const QString &text);
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+private:
+    struct Entry
+    {
+        qint64 timeMs;
+        QString text;
+    };
+
+    void flush();
+
+    QVector<Entry> entries;     // 环形缓冲区，大小固定为 capacity
+    int head;                   // 最旧一条所在位置
+    int count;
+    QVector<Entry> pending;     // 尚未插入模型的条目，满了以后同样环形覆盖
+    int pendingHead;
+    QTimer flushTimer;
+};
+
+#endif // LOGMODEL_H
@@ -1,10 +1,24 @@
 #include "mainwindow.h"
+#include "mapcache.h"
 #include <QApplication>
+#include <QThread>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QWebEngineUrlScheme>
+#endif
 
 
 int main(int argc, char *argv[])
 {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    // 地图离线缓存的 URL scheme，必须在创建 QApplication 之前注册
+    QWebEngineUrlScheme cacheScheme(MapCache::scheme());
+    cacheScheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    cacheScheme.setFlags(QWebEngineUrlScheme::LocalAccessAllowed);
+    QWebEngineUrlScheme::registerScheme(cacheScheme);
+#endif
+
     QApplication a(argc, argv);
+    QThread::currentThread()->setObjectName("ui");
     MainWindow w;
     w.show();
 
@@ -1,14 +1,31 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "cameracapture.h"
+#include "videowidget.h"
+#include "videorecorder.h"
+#include "mapbridge.h"
+#include "mapcachehandler.h"
+#include "perfstats.h"
+#include "logging.h"
+#include "trace.h"
+#include "timeseries.h"
+#include "telemetrychart.h"
+#include "geotagger.h"
 
 #include <QApplication>
 #include <QWebEnginePage>
 #include <QWebEngineView>
 #include <QWebChannel>
+#include <QWebEngineProfile>
 #include <QDebug>
+#include <QScreen>
+#include <QtNumeric>
+#include <QFileInfo>
+#include <QDateTime>
 
 
 #include <math.h>
+#include <iostream>
 
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -16,8 +33,6 @@ MainWindow::MainWindow(QWidget *parent) :
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
-    timer   = new QTimer(this);
-    imag    = new QImage();         // 初始化
 
     server_ = new Ui::Server(this);
     dock_server_ = new QDockWidget("Info", this);
@@ -25,45 +40,159 @@ MainWindow::MainWindow(QWidget *parent) :
     addDockWidget(Qt::LeftDockWidgetArea, dock_server_);
     //dock_server_->setFloating(1);
 
+    // 历史曲线；回放开始和结束时清空，避免实时和回放的时间轴混在一起。
+    // 只能按时间顺序追加，回放往回跳转后也要清空，否则曲线停住不动
+    series_ = new TimeSeriesStore;
+    connect(server_, &Ui::Server::sampleReceived, this, [this](const TelemetrySample &sample) {
+        series_->append(sample);
+    });
+    replaying_ = false;
+    connect(server_, &Ui::Server::replayOpened, this, [this]() {
+        series_->clear();
+        predictor_.reset();
+        replaying_ = true;
+    });
+    connect(server_, &Ui::Server::replayClosed, this, [this]() {
+        series_->clear();
+        predictor_.reset();
+        replaying_ = false;
+    });
+    connect(server_, &Ui::Server::replaySeeked, this, [this]() {
+        series_->clear();
+    });
+    dock_charts_ = new QDockWidget("Charts", this);
+    dock_charts_->setWidget(new ChartPanel(series_, dock_charts_));
+    addDockWidget(Qt::RightDockWidgetArea, dock_charts_);
+
     QString strPath = "file://";
     strPath += qApp->applicationDirPath();
     strPath += "/index.html";
-    qDebug() << strPath;
+    qCDebug(lcUi) << strPath;
+    mapBridge_ = new MapBridge(20, this);
+    connect(server_, &Ui::Server::sampleReceived, mapBridge_, &MapBridge::addSample);
+    // 和历史曲线一样，回放开始、结束和跳转时航迹重新开始
+    connect(server_, &Ui::Server::replayOpened, mapBridge_, &MapBridge::clearTrack);
+    connect(server_, &Ui::Server::replayClosed, mapBridge_, &MapBridge::clearTrack);
+    connect(server_, &Ui::Server::replaySeeked, mapBridge_, &MapBridge::clearTrack);
+
+    // 实时数据才外推和标注关键帧；回放的时间戳是录制时的，直接显示记录的位置
+    geoTagger = new GeoTagger(this);
+    connect(server_, &Ui::Server::sampleReceived, this, [this](const TelemetrySample &sample) {
+        if (replaying_)
+            return;
+        geoTagger->addSample(sample);
+        if (sample.sections & TelemetrySample::GPS)
+            predictor_.addFix(sample, Telemetry::monotonicNs(), QDateTime::currentMSecsSinceEpoch());
+    });
+    connect(server_, &Ui::Server::keyframeCaptureStarted, geoTagger, &GeoTagger::start);
+    connect(server_, &Ui::Server::keyframeCaptureStopped, geoTagger, &GeoTagger::stop);
+    connect(geoTagger, &GeoTagger::captureFailed, this, [](const QString &error) {
+        std::cerr << error.toStdString() << std::endl;
+    });
+
+    // 地图 API 和瓦片走本地缓存（bin/cache），离线时也能显示已缓存的区域
+    QWebEngineProfile *profile = ui->webView->page()->profile();
+    profile->installUrlSchemeHandler(MapCache::scheme(),
+                                     new MapCacheHandler(qApp->applicationDirPath() + "/cache", this));
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    profile->setUrlRequestInterceptor(new MapCacheInterceptor(this));
+#else
+    profile->setRequestInterceptor(new MapCacheInterceptor(this));
+#endif
+
     QWebChannel *channel = new QWebChannel(this);
     channel->registerObject("MainWindow", this);
+    channel->registerObject("MapBridge", mapBridge_);
     ui->webView->page()->setWebChannel(channel);
     ui->webView->page()->load(QUrl(strPath));
 
+    // 读数由新遥测驱动：没有数据时不刷新，数据密集时每个屏幕刷新周期最多一次；
+    // 两次定位之间外推位置时按屏幕刷新率持续刷新
     timer_1 = new QTimer(this);
-    timer->start(100);
+    timer_1->setSingleShot(true);
+    timer_1->setInterval(qMax(1, qRound(1000.0 / qMax(1.0, QGuiApplication::primaryScreen()->refreshRate()))));
+    connect(timer_1, &QTimer::timeout, this, &MainWindow::timeCountsFunction);
+    connect(server_, &Ui::Server::telemetryChanged, this, &MainWindow::scheduleReadouts);
+    shown_ = TelemetrySample();               // NaN 与任何值都不等，保证第一次全部刷新
+    shown_.longitude = shown_.latitude = shown_.altitude = qQNaN();
+    shown_.velocityX = shown_.velocityZ = shown_.batteryPercent = qQNaN();
 
-    timer_2 = new QTimer(this);
-    timer_2->start(1000);
+    // 画面默认用 OpenGL 显示；GPSVIEW_VIDEO=label 时退回 QLabel 预览图
+    video = 0;
+    if (qgetenv("GPSVIEW_VIDEO") != "label") {
+        video = new VideoWidget(this);
+        ui->horizontalLayout_3->replaceWidget(ui->label_3, video);
+        ui->label_3->hide();
+    }
 
-    cam = cv::VideoCapture(0);//打开摄像头，从摄像头中获取视频
-    if(!cam.isOpened())
-        std::cerr << "Can't open camera!" <<std::endl;;
+    // 摄像头在采集线程中读取和缩放，有新帧时通知界面
+    camera = new CameraCapture(0, QSize(400, 400), this);
+    shownFrameIndex = 0;
+    camera->setPreviewEnabled(!video);
+    videoRecorder = new VideoRecorder(this);
+    camera->setRecorder(videoRecorder);
+    connect(server_, &Ui::Server::recordingStarted, this, &MainWindow::startVideoRecording);
+    connect(server_, &Ui::Server::recordingStopped, videoRecorder, &VideoRecorder::stopRecording);
+    connect(videoRecorder, &VideoRecorder::recordingFailed, this, [](const QString &error) {
+        std::cerr << error.toStdString() << std::endl;
+    });
 
-    timer->start(33);              // 开始计时，超时则发出timeout()信号
-    connect(timer, SIGNAL(timeout()), this, SLOT(readFarme()));  // 时间到，读取当前摄像头信息
+    review = new VideoReview;
+    connect(server_, &Ui::Server::replayOpened, this, &MainWindow::openReview);
+    connect(server_, &Ui::Server::replayClosed, this, &MainWindow::closeReview);
+    connect(server_, &Ui::Server::replayTimeChanged, this, &MainWindow::showReviewFrame);
+    connect(camera, &CameraCapture::frameReady, this, &MainWindow::readFarme);
+    connect(camera, &CameraCapture::cameraError, this, [](const QString &error) {
+        std::cerr << error.toStdString() << std::endl;
+    });
+    camera->start();
 }
 
 MainWindow::~MainWindow()
 {
+    closeCamara();
+    geoTagger->stop();
+    delete review;
+    delete series_;
     delete ui;
 }
 
+void MainWindow::scheduleReadouts()
+{
+    if (!timer_1->isActive())
+        timer_1->start();
+}
+
 void MainWindow::timeCountsFunction()
 {
-    ui->lineEditLng->setText(QString::number(server_->jsonGPS["longitude"].toDouble()));
-    //qDebug() <<"\n->"<< server_->jsonGPS["altitude"].toString();
-    ui->lineEditLat->setText(QString::number(server_->jsonGPS["latitude"].toDouble()));
-    ui->Alt->setText(QString::number(server_->jsonGPS["altitude"].toDouble()));
+    Trace::Span span("update readouts");
+    TelemetrySample t = server_->telemetry;
+    const qint64 now = Telemetry::monotonicNs();
+    predictor_.position(now, t.longitude, t.latitude, t.altitude, t.yaw);
+
+    // 只改变化了的控件，避免多余的格式化和重绘
+    if (t.longitude != shown_.longitude)
+        ui->lineEditLng->setText(QString::number(t.longitude));
+    if (t.latitude != shown_.latitude)
+        ui->lineEditLat->setText(QString::number(t.latitude));
+    if (t.altitude != shown_.altitude)
+        ui->Alt->setText(QString::number(t.altitude));
 
-    ui->VelH->setText(QString::number(sqrt(pow(server_->jsonGPS["velocityY"].toDouble(),2)+pow(server_->jsonGPS["velocityX"].toDouble(), 2))));
-    ui->VelV->setText(QString::number(server_->jsonGPS["velocityZ"].toDouble()));
+    if (t.velocityX != shown_.velocityX || t.velocityY != shown_.velocityY)
+        ui->VelH->setText(QString::number(sqrt(t.velocityY*t.velocityY + t.velocityX*t.velocityX)));
+    if (t.velocityZ != shown_.velocityZ)
+        ui->VelV->setText(QString::number(t.velocityZ));
 
-    ui->Bat->setText(QString::number(server_->jsonBattery["BatteryEnergyRemainingPercent"].toDouble()));
+    if (t.batteryPercent != shown_.batteryPercent)
+        ui->Bat->setText(QString::number(t.batteryPercent));
+
+    if ((t.sections & TelemetrySample::GPS)
+            && (t.longitude != shown_.longitude || t.latitude != shown_.latitude || t.yaw != shown_.yaw))
+        mapBridge_->moveMarker(t.longitude, t.latitude, t.yaw);
+
+    shown_ = t;
+    if (predictor_.isMoving(now))
+        timer_1->start();
 }
 
 void MainWindow::QtTest()
@@ -73,20 +202,8 @@ void MainWindow::QtTest()
 
 void MainWindow::on_pushButton_clicked()
 {
-    connect(timer_1,SIGNAL(timeout()),this,SLOT(timeCountsFunction()));
-    connect(timer_2,SIGNAL(timeout()),this,SLOT(callJava()));
-}
-
-void MainWindow::callJava()
-{
-    QString strJs_ = "myFunction(%1, %2, ";
-    strJs_ += QString::number(server_->jsonGPS["yaw"].toDouble(), 10, 1);
-    strJs_ += ")";
-    QString strJs = strJs_
-            .arg(ui->lineEditLng->text().toDouble()*0.01+116)
-            .arg(ui->lineEditLat->text().toDouble()*0.01+29);
-    ui->webView->page()->runJavaScript(strJs);
-    qDebug() << "\n->" <<strJs;
+    // 开始向地图推送位置
+    mapBridge_->setEnabled(true);
 }
 
 /*********************************
@@ -94,10 +211,28 @@ void MainWindow::callJava()
 **********************************/
 void MainWindow::readFarme()
 {
-    cam >> frame;// 从摄像头中抓取并返回每一帧
-    // 将抓取到的帧，转换为QImage格式。QImage::Format_RGB888不同的摄像头用不同的格式。
-    QImage image = QImage(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step), QImage::Format_RGB888).rgbSwapped().scaled(400,400,Qt::KeepAspectRatio);
-    ui->label_3->setPixmap(QPixmap::fromImage(image));  // 将图片显示到label上
+    // 只取最新的一帧，旧帧已被丢弃
+    const CameraFrame *frame = camera->takeLatest();
+    if (!frame || review->isOpen())
+        return;
+
+    Trace::Span span("show frame", frame->index);
+
+    // 序号不连续说明中间的帧被覆盖了
+    if (shownFrameIndex && frame->index > shownFrameIndex + 1)
+        Perf::add(Perf::CameraFramesDropped, frame->index - shownFrameIndex - 1);
+    shownFrameIndex = frame->index;
+
+    const qint64 displayStart = Telemetry::monotonicNs();
+    if (video) {
+        // 原始 BGR 帧直接上传为纹理，换色和缩放在着色器中完成
+        video->setFrame(frame->raw.data, frame->raw.cols, frame->raw.rows, int(frame->raw.step));
+    } else {
+        ui->label_3->setPixmap(QPixmap::fromImage(frame->preview));  // 将图片显示到label上
+    }
+    Perf::record(Perf::DisplayTime, Telemetry::monotonicNs() - displayStart);
+
+    geoTagger->offerFrame(frame->raw, frame->timestampNs);
 }
 
 /*******************************
@@ -105,6 +240,40 @@ void MainWindow::readFarme()
 ********************************/
 void MainWindow::closeCamara()
 {
-    timer->stop();         // 停止读取数据。
-    cam.release();//释放内存；
+    camera->stop();        // 停止读取数据，采集线程退出时释放摄像头
+}
+
+/*******************************
+*** 录像：与飞行记录同名，另有帧时刻索引 ***
+********************************/
+void MainWindow::startVideoRecording(const QString &baseName)
+{
+    videoRecorder->startRecording(baseName + ".avi", baseName + ".vidx", camera->frameRate());
+}
+
+// 回放的记录有同名录像时，画面跟随回放时刻
+void MainWindow::openReview(const QString &recordFile)
+{
+    QString baseName = recordFile;
+    baseName.chop(QFileInfo(recordFile).suffix().size() + 1);
+    review->open(baseName + ".avi", baseName + ".vidx");
+}
+
+void MainWindow::closeReview()
+{
+    review->close();
+}
+
+void MainWindow::showReviewFrame(qint64 timeNs)
+{
+    const cv::Mat *frame = review->frameAt(timeNs);
+    if (!frame || frame->type() != CV_8UC3)
+        return;
+
+    if (video) {
+        video->setFrame(frame->data, frame->cols, frame->rows, int(frame->step));
+        return;
+    }
+    const QImage image(frame->data, frame->cols, frame->rows, int(frame->step), QImage::Format_RGB888);
+    ui->label_3->setPixmap(QPixmap::fromImage(image.rgbSwapped().scaled(400, 400, Qt::KeepAspectRatio)));
 }
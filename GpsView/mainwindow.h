@@ -6,10 +6,16 @@
 #include <QTime>
 #include <QWebEngineView>
 #include "server.h"
+#include "deadreckoning.h"
 
-#include <opencv2/highgui/highgui.hpp>
-#include <opencv2/opencv.hpp>
-#include <opencv2/video/video.hpp>
+class CameraCapture;
+class VideoWidget;
+class VideoRecorder;
+class VideoReview;
+class GeoTagger;
+class TimeSeriesStore;
+class ChartPanel;
+class MapBridge;
 
 namespace Ui {
 class MainWindow;
@@ -29,26 +35,37 @@ public:
 private slots:
     void on_pushButton_clicked();
     void timeCountsFunction();
-    void callJava();
+    void scheduleReadouts();
 private:
     Ui::MainWindow *ui;
 
     Ui::Server *server_;
     QDockWidget* dock_server_;
+    QDockWidget* dock_charts_;
+    TimeSeriesStore* series_;      // 高度、速度、电量的历史，供曲线使用
 
-    QTimer* timer_1;
-    QTimer* timer_2;
+    QTimer* timer_1;               // 读数刷新，合并到屏幕刷新率
+    MapBridge* mapBridge_;         // 经 QWebChannel 向地图批量推送位置
+    TelemetrySample shown_;        // 已显示在读数上的值
+    DeadReckoning predictor_;      // 两次定位之间外推标记和读数的位置；回放时不用
+    bool replaying_;
 
 
 private slots:
     void readFarme();       // 读取当前帧信息
     void closeCamara();     // 关闭摄像头。
+    void startVideoRecording(const QString &baseName);
+    void openReview(const QString &recordFile);
+    void closeReview();
+    void showReviewFrame(qint64 timeNs);
 
 private:
-    QTimer    *timer;
-    QImage    *imag;
-    cv::VideoCapture cam;
-    cv::Mat  frame;
+    CameraCapture *camera;  // 摄像头采集线程
+    quint64 shownFrameIndex;    // 上一次显示的帧序号，用于统计丢帧
+    VideoWidget *video;     // OpenGL 画面；为 0 时用 label_3 显示预览图
+    VideoRecorder *videoRecorder;  // 与飞行记录同时开始和停止
+    VideoReview *review;    // 回放记录时显示对应的录像，期间不显示实时画面
+    GeoTagger *geoTagger;   // 关键帧和位置先验，供 COLMAP 建模
 };
 
 #endif // MAINWINDOW_H
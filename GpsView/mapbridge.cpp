@@ -0,0 +1,95 @@
+#include "mapbridge.h"
+#include "coordtransform.h"
+#include "trace.h"
+
+
+MapBridge::MapBridge(int flushRate, QObject *parent)
+    : QObject(parent),
+      enabled(false),
+      pendingLng(MaxBatch),
+      pendingLat(MaxBatch),
+      pendingFirst(0),
+      pendingCount(0),
+      lastYaw(0)
+{
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(1000 / qMax(1, flushRate));
+    connect(&flushTimer, &QTimer::timeout, this, &MapBridge::flush);
+}
+
+void MapBridge::setEnabled(bool on)
+{
+    enabled = on;
+}
+
+void MapBridge::requestTrack(int zoom, double west, double south, double east, double north)
+{
+    emit trackUpdated(track.query(zoom, west, south, east, north));
+}
+
+void MapBridge::addSample(const TelemetrySample &sample)
+{
+    // 未开始推送时也记录航迹
+    if (!(sample.sections & TelemetrySample::GPS))
+        return;
+
+    // 满了就覆盖最旧的一个
+    const int at = (pendingFirst + pendingCount) % MaxBatch;
+    if (pendingCount < MaxBatch)
+        ++pendingCount;
+    else
+        pendingFirst = (pendingFirst + 1) % MaxBatch;
+
+    pendingLng[at] = sample.longitude;
+    pendingLat[at] = sample.latitude;
+    lastYaw = sample.yaw;
+
+    if (!flushTimer.isActive())
+        flushTimer.start();
+}
+
+void MapBridge::clearTrack()
+{
+    track.clear();
+    pendingFirst = 0;
+    pendingCount = 0;
+    flushTimer.stop();
+    if (enabled)
+        emit trackUpdated(QVariantList());
+}
+
+void MapBridge::moveMarker(double lng, double lat, double heading)
+{
+    if (!enabled)
+        return;
+
+    double bdLng, bdLat;
+    CoordTransform::wgs84ToBd09(lng, lat, bdLng, bdLat);
+    emit markerMoved(bdLng, bdLat, heading);
+}
+
+void MapBridge::flush()
+{
+    if (pendingCount == 0)
+        return;
+    Trace::Span span("push to map");
+
+    // 整批在本地转换成百度坐标，结果就地写回；绕回时分两段
+    const int head = qMin(pendingCount, MaxBatch - pendingFirst);
+    const int parts[2][2] = { { pendingFirst, head }, { 0, pendingCount - head } };
+    for (int i = 0; i < 2; ++i) {
+        const int from = parts[i][0], count = parts[i][1];
+        if (count == 0)
+            continue;
+        CoordTransform::wgs84ToBd09(pendingLng.constData() + from, pendingLat.constData() + from,
+                                    pendingLng.data() + from, pendingLat.data() + from, count);
+        track.append(pendingLng.constData() + from, pendingLat.constData() + from, count);
+    }
+
+    if (enabled) {
+        const int last = (pendingFirst + pendingCount - 1) % MaxBatch;
+        emit positionUpdated(pendingLng[last], pendingLat[last], lastYaw);
+    }
+    pendingFirst = 0;
+    pendingCount = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef MAPBRIDGE_H
+#define MAPBRIDGE_H
+
+#include <QObject>
+#include <QVariantList>
+#include <QTimer>
+#include <QVector>
+
+#include "telemetrysample.h"
+#include "trackstore.h"
+
+// 通过 QWebChannel 暴露给地图页面的对象。
+// 收到的位置先攒在本地，按固定频率一次性转换成百度坐标（BD-09）记入航迹，
+// 页面只收到最新的位置，不再编译脚本，也不再调用远程坐标转换。
+// 同时记录整条航迹，页面按当前缩放级别和视野取简化后的折线。
+class MapBridge : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MapBridge(int flushRate = 20, QObject *parent = 0);
+
+    void setEnabled(bool enabled);
+    void addSample(const TelemetrySample &sample);
+    // 清空航迹和未发出的位置，回放开始、结束和跳转时调用
+    void clearTrack();
+    // 标记的显示位置（WGS-84），可以是外推的，按屏幕刷新率调用
+    void moveMarker(double lng, double lat, double heading);
+
+public slots:
+    // 由页面在缩放、移动或收到新位置后调用，结果经 trackUpdated 返回
+    void requestTrack(int zoom, double west, double south, double east, double north);
+
+signals:
+    // 一批定位中最新的一个，BD-09；航迹经 requestTrack 获取
+    void positionUpdated(double lng, double lat, double heading);
+    // 标记位置，BD-09
+    void markerMoved(double lng, double lat, double heading);
+    // 视野内的航迹，每项为一段 [lng, lat, lng, lat, ...]
+    void trackUpdated(const QVariantList &runs);
+
+private:
+    void flush();
+
+    enum { MaxBatch = 1000 };  // 单批最多的点数，超出时覆盖最旧的
+
+    bool enabled;
+    // 环形缓冲区，WGS-84，经纬度分开存放便于批量转换
+    QVector<double> pendingLng;
+    QVector<double> pendingLat;
+    int pendingFirst;
+    int pendingCount;
+    double lastYaw;
+    QTimer flushTimer;
+    TrackStore track;
+};
+
+#endif // MAPBRIDGE_H
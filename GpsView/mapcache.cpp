@@ -0,0 +1,116 @@
+#include "mapcache.h"
+
+#include <QUrlQuery>
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+
+
+MapCache::MapCache(const QString &root, int maxMapped)
+    : rootDir(root),
+      mapped(maxMapped)
+{
+}
+
+bool MapCache::isCacheable(const QUrl &url)
+{
+    if (url.scheme() != "http" && url.scheme() != "https")
+        return false;
+    const QString host = url.host();
+    return host.endsWith("baidu.com") || host.endsWith("bdimg.com")
+            || host.endsWith("bdstatic.com");
+}
+
+// 原始 URL 以十六进制放在路径里，避免再次转义带来的歧义：gvcache://cache/<hex>
+QUrl MapCache::cacheUrl(const QUrl &original)
+{
+    return QUrl(QString("%1://cache/%2").arg(scheme())
+                .arg(QString::fromLatin1(original.toEncoded().toHex())));
+}
+
+QUrl MapCache::originalUrl(const QUrl &cacheUrl)
+{
+    return QUrl::fromEncoded(QByteArray::fromHex(cacheUrl.path().mid(1).toLatin1()));
+}
+
+bool MapCache::tileForUrl(const QUrl &url, int &z, int &x, int &y)
+{
+    const QUrlQuery query(url);
+    if (query.queryItemValue("qt") != "tile")
+        return false;
+
+    bool okZ, okX, okY;
+    z = query.queryItemValue("z").toInt(&okZ);
+    x = query.queryItemValue("x").toInt(&okX);
+    y = query.queryItemValue("y").toInt(&okY);
+    return okZ && okX && okY;
+}
+
+QString MapCache::tilePath(int z, int x, int y)
+{
+    return QString("tiles/%1/%2/%3.png").arg(z).arg(x).arg(y);
+}
+
+QString MapCache::pathForUrl(const QUrl &url) const
+{
+    int z, x, y;
+    if (tileForUrl(url, z, x, y))
+        return rootDir + '/' + tilePath(z, x, y);
+
+    const QByteArray hash = QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex();
+    return rootDir + "/assets/" + QString::fromLatin1(hash);
+}
+
+MapCache::MappedFilePointer MapCache::open(const QUrl &url)
+{
+    const QString path = pathForUrl(url);
+    if (MappedFilePointer *cached = mapped.object(path))
+        return *cached;
+
+    MappedFilePointer file(new MappedFile);
+    file->file.setFileName(path);
+    if (!file->file.open(QIODevice::ReadOnly) || file->file.size() == 0)
+        return MappedFilePointer();
+
+    file->size = file->file.size();
+    file->data = file->file.map(0, file->size);
+    if (!file->data)
+        return MappedFilePointer();
+
+    int z, x, y;
+    if (tileForUrl(url, z, x, y)) {
+        file->mimeType = "image/png";
+    } else {
+        QFile type(path + ".type");
+        if (type.open(QIODevice::ReadOnly))
+            file->mimeType = type.readAll().trimmed();
+        if (file->mimeType.isEmpty())
+            file->mimeType = "application/octet-stream";
+    }
+
+    mapped.insert(path, new MappedFilePointer(file));
+    return file;
+}
+
+bool MapCache::store(const QUrl &url, const QByteArray &data, const QByteArray &mimeType)
+{
+    const QString path = pathForUrl(url);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // 先写临时文件再改名，读到的总是完整文件
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit())
+        return false;
+
+    int z, x, y;
+    if (!tileForUrl(url, z, x, y)) {
+        QSaveFile type(path + ".type");
+        if (type.open(QIODevice::WriteOnly)) {
+            type.write(mimeType);
+            type.commit();
+        }
+    }
+    mapped.remove(path);
+    return true;
+}
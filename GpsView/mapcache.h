@@ -0,0 +1,52 @@
+#ifndef MAPCACHE_H
+#define MAPCACHE_H
+
+#include <QString>
+#include <QUrl>
+#include <QFile>
+#include <QCache>
+#include <QSharedPointer>
+
+// 地图离线缓存。目录结构：
+//   <root>/tiles/<z>/<x>/<y>.png     地图瓦片金字塔，tileprefetch 预先下载
+//   <root>/assets/<sha1>             其他资源（地图 JS API、图标等），文件名为 URL 的 SHA-1
+//   <root>/assets/<sha1>.type        对应的 Content-Type
+// 读取时用 mmap 映射文件，最近用过的映射保留在内存中。
+class MapCache
+{
+public:
+    // 映射到内存的缓存文件，最后一个引用释放时解除映射
+    struct MappedFile
+    {
+        QFile file;
+        const uchar *data;
+        qint64 size;
+        QByteArray mimeType;
+    };
+    typedef QSharedPointer<MappedFile> MappedFilePointer;
+
+    static const char *scheme() { return "gvcache"; }
+
+    explicit MapCache(const QString &root, int maxMapped = 256);
+
+    // 是否需要经过缓存，以及原始 URL 和缓存 URL 的相互转换
+    static bool isCacheable(const QUrl &url);
+    static QUrl cacheUrl(const QUrl &original);
+    static QUrl originalUrl(const QUrl &cacheUrl);
+
+    // 百度瓦片地址（qt=tile&x=&y=&z=）对应的瓦片坐标
+    static bool tileForUrl(const QUrl &url, int &z, int &x, int &y);
+    static QString tilePath(int z, int x, int y);
+
+    QString pathForUrl(const QUrl &url) const;
+
+    // 没有缓存时返回空指针
+    MappedFilePointer open(const QUrl &url);
+    bool store(const QUrl &url, const QByteArray &data, const QByteArray &mimeType);
+
+private:
+    QString rootDir;
+    QCache<QString, MappedFilePointer> mapped;
+};
+
+#endif // MAPCACHE_H
@@ -0,0 +1,82 @@
+#include "mapcachehandler.h"
+
+#include <QWebEngineUrlRequestJob>
+#include <QNetworkReply>
+#include <QBuffer>
+#include <QPointer>
+
+
+namespace {
+
+// 直接读映射内存的设备，持有映射直到请求结束
+class MappedDevice : public QBuffer
+{
+public:
+    MappedDevice(const MapCache::MappedFilePointer &file, QObject *parent)
+        : QBuffer(parent), mapping(file)
+    {
+        setData(QByteArray::fromRawData(reinterpret_cast<const char *>(file->data), int(file->size)));
+        open(QIODevice::ReadOnly);
+    }
+
+private:
+    MapCache::MappedFilePointer mapping;
+};
+
+} // namespace
+
+MapCacheInterceptor::MapCacheInterceptor(QObject *parent)
+    : QWebEngineUrlRequestInterceptor(parent)
+{
+}
+
+void MapCacheInterceptor::interceptRequest(QWebEngineUrlRequestInfo &info)
+{
+    if (info.requestMethod() == "GET" && MapCache::isCacheable(info.requestUrl()))
+        info.redirect(MapCache::cacheUrl(info.requestUrl()));
+}
+
+MapCacheHandler::MapCacheHandler(const QString &root, QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent),
+      cache(root)
+{
+}
+
+void MapCacheHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    const QUrl url = MapCache::originalUrl(job->requestUrl());
+    if (!MapCache::isCacheable(url)) {
+        job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+        return;
+    }
+
+    MapCache::MappedFilePointer file = cache.open(url);
+    if (file) {
+        job->reply(file->mimeType, new MappedDevice(file, job));
+        return;
+    }
+
+    // 未缓存：联网取回并写入缓存。页面可能在下载期间取消请求
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+    QNetworkReply *reply = network.get(request);
+    QPointer<QWebEngineUrlRequestJob> pendingJob(job);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, url, pendingJob]() {
+        reply->deleteLater();
+        const QByteArray mimeType = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+        const QByteArray data = reply->error() == QNetworkReply::NoError ? reply->readAll() : QByteArray();
+        if (!data.isEmpty())
+            cache.store(url, data, mimeType);
+
+        if (!pendingJob)
+            return;
+        if (data.isEmpty()) {
+            pendingJob->fail(QWebEngineUrlRequestJob::RequestFailed);
+            return;
+        }
+        QBuffer *buffer = new QBuffer(pendingJob);
+        buffer->setData(data);
+        buffer->open(QIODevice::ReadOnly);
+        pendingJob->reply(mimeType.isEmpty() ? QByteArray("application/octet-stream") : mimeType, buffer);
+    });
+}
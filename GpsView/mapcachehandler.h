@@ -0,0 +1,38 @@
+#ifndef MAPCACHEHANDLER_H
+#define MAPCACHEHANDLER_H
+
+#include <QWebEngineUrlSchemeHandler>
+#include <QWebEngineUrlRequestInterceptor>
+#include <QNetworkAccessManager>
+
+#include "mapcache.h"
+
+// 把地图页面对百度服务器的请求改写到 gvcache:// 上
+class MapCacheInterceptor : public QWebEngineUrlRequestInterceptor
+{
+    Q_OBJECT
+
+public:
+    explicit MapCacheInterceptor(QObject *parent = 0);
+
+    // 在 WebEngine 的 IO 线程中调用，只做 URL 判断
+    void interceptRequest(QWebEngineUrlRequestInfo &info);
+};
+
+// 处理 gvcache:// 请求：优先从本地缓存映射返回，
+// 没有缓存时联网下载，写入缓存后再返回；离线又未缓存时请求失败。
+class MapCacheHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+public:
+    explicit MapCacheHandler(const QString &root, QObject *parent = 0);
+
+    void requestStarted(QWebEngineUrlRequestJob *job);
+
+private:
+    MapCache cache;
+    QNetworkAccessManager network;
+};
+
+#endif // MAPCACHEHANDLER_H
@@ -0,0 +1,76 @@
+#include "perfpanel.h"
+#include "telemetrysample.h"
+
+#include <QFontDatabase>
+
+
+namespace {
+
+QString formatDuration(double ns)
+{
+    if (ns < 1000)
+        return QString("%1 ns").arg(ns, 0, 'f', 0);
+    if (ns < 1000000)
+        return QString("%1 us").arg(ns / 1000, 0, 'f', 1);
+    return QString("%1 ms").arg(ns / 1000000, 0, 'f', 2);
+}
+
+} // namespace
+
+PerfPanel::PerfPanel(QWidget *parent)
+    : QPlainTextEdit(parent),
+      previousNs(0)
+{
+    setReadOnly(true);
+    setLineWrapMode(QPlainTextEdit::NoWrap);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setMaximumHeight(fontMetrics().lineSpacing() * (Perf::CounterCount + Perf::HistogramCount + 3));
+
+    refreshTimer.setInterval(500);
+    connect(&refreshTimer, &QTimer::timeout, this, &PerfPanel::refresh);
+}
+
+void PerfPanel::showEvent(QShowEvent *event)
+{
+    QPlainTextEdit::showEvent(event);
+    previous = Perf::collect();
+    previousNs = Telemetry::monotonicNs();
+    refreshTimer.start();
+}
+
+void PerfPanel::hideEvent(QHideEvent *event)
+{
+    refreshTimer.stop();
+    QPlainTextEdit::hideEvent(event);
+}
+
+void PerfPanel::refresh()
+{
+    const Perf::Snapshot now = Perf::collect();
+    const qint64 nowNs = Telemetry::monotonicNs();
+    const Perf::Snapshot d = Perf::difference(now, previous);
+    const double seconds = qMax(1e-3, (nowNs - previousNs) / 1e9);
+    previous = now;
+    previousNs = nowNs;
+
+    QString text;
+    for (int i = 0; i < Perf::CounterCount; ++i) {
+        const Perf::Counter c = Perf::Counter(i);
+        text += QString("%1 %2/s  (total %3)\n")
+                .arg(QString(Perf::name(c)), -22)
+                .arg(d.counters[i] / seconds, 10, 'f', 1)
+                .arg(now.counters[i]);
+    }
+    text += "\n";
+    for (int i = 0; i < Perf::HistogramCount; ++i) {
+        const Perf::Histogram h = Perf::Histogram(i);
+        const double p50 = Perf::percentile(d, h, 0.50);
+        const double p99 = Perf::percentile(d, h, 0.99);
+        text += QString("%1 %2/s  p50 %3  p99 %4\n")
+                .arg(QString(Perf::name(h)), -22)
+                .arg(Perf::count(d, h) / seconds, 10, 'f', 1)
+                .arg(Perf::isDuration(h) ? formatDuration(p50) : QString::number(p50, 'f', 0), 10)
+                .arg(Perf::isDuration(h) ? formatDuration(p99) : QString::number(p99, 'f', 0), 10);
+    }
+    setPlainText(text);
+}
@@ -0,0 +1,30 @@
+#ifndef PERFPANEL_H
+#define PERFPANEL_H
+
+#include <QPlainTextEdit>
+#include <QTimer>
+
+#include "perfstats.h"
+
+// 性能统计面板：显示时每隔一段时间汇总一次 Perf 的计数，
+// 给出这段时间内的速率和分位数；隐藏时不做任何事
+class PerfPanel : public QPlainTextEdit
+{
+    Q_OBJECT
+
+public:
+    explicit PerfPanel(QWidget *parent = 0);
+
+protected:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+
+private:
+    void refresh();
+
+    QTimer refreshTimer;
+    Perf::Snapshot previous;
+    qint64 previousNs;
+};
+
+#endif // PERFPANEL_H
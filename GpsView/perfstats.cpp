@@ -0,0 +1,154 @@
+#include "perfstats.h"
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QVector>
+#include <QtAlgorithms>
+
+#include <cstring>
+
+
+namespace {
+
+struct ThreadStats
+{
+    QAtomicInteger<quint64> counters[Perf::CounterCount];
+    QAtomicInteger<quint64> buckets[Perf::HistogramCount][Perf::BucketCount];
+};
+
+// 线程退出后统计区保留，累计值不会因线程结束而减少；线程数很少，不回收
+QMutex &registryLock()
+{
+    static QMutex lock;
+    return lock;
+}
+
+QVector<ThreadStats *> &registry()
+{
+    static QVector<ThreadStats *> blocks;
+    return blocks;
+}
+
+ThreadStats *threadStats()
+{
+    static thread_local ThreadStats *stats = 0;
+    if (!stats) {
+        stats = new ThreadStats;
+        QMutexLocker locker(&registryLock());
+        registry().append(stats);
+    }
+    return stats;
+}
+
+// 只有所属线程写，不需要原子加
+inline void bump(QAtomicInteger<quint64> &value, quint64 n)
+{
+    value.store(value.load() + n);
+}
+
+inline int bucketFor(qint64 value)
+{
+    if (value <= 0)
+        return 0;
+    return qMin(int(Perf::BucketCount) - 1, 64 - int(qCountLeadingZeroBits(quint64(value))));
+}
+
+} // namespace
+
+namespace Perf {
+
+void add(Counter counter, quint64 n)
+{
+    bump(threadStats()->counters[counter], n);
+}
+
+void record(Histogram histogram, qint64 value)
+{
+    bump(threadStats()->buckets[histogram][bucketFor(value)], 1);
+}
+
+Snapshot collect()
+{
+    Snapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    QMutexLocker locker(&registryLock());
+    const QVector<ThreadStats *> &blocks = registry();
+    for (int t = 0; t < blocks.size(); ++t) {
+        const ThreadStats *stats = blocks[t];
+        for (int i = 0; i < CounterCount; ++i)
+            snapshot.counters[i] += stats->counters[i].loadAcquire();
+        for (int h = 0; h < HistogramCount; ++h) {
+            for (int b = 0; b < BucketCount; ++b)
+                snapshot.buckets[h][b] += stats->buckets[h][b].loadAcquire();
+        }
+    }
+    return snapshot;
+}
+
+Snapshot difference(const Snapshot &later, const Snapshot &earlier)
+{
+    Snapshot d;
+    for (int i = 0; i < CounterCount; ++i)
+        d.counters[i] = later.counters[i] - earlier.counters[i];
+    for (int h = 0; h < HistogramCount; ++h) {
+        for (int b = 0; b < BucketCount; ++b)
+            d.buckets[h][b] = later.buckets[h][b] - earlier.buckets[h][b];
+    }
+    return d;
+}
+
+quint64 count(const Snapshot &snapshot, Histogram histogram)
+{
+    quint64 n = 0;
+    for (int b = 0; b < BucketCount; ++b)
+        n += snapshot.buckets[histogram][b];
+    return n;
+}
+
+double percentile(const Snapshot &snapshot, Histogram histogram, double p)
+{
+    const quint64 total = count(snapshot, histogram);
+    if (!total)
+        return 0;
+
+    const double rank = p * total;
+    quint64 seen = 0;
+    for (int b = 0; b < BucketCount; ++b) {
+        const quint64 n = snapshot.buckets[histogram][b];
+        if (seen + n >= rank && n) {
+            if (b == 0)
+                return 0;
+            const double low = b == 1 ? 1.0 : double(quint64(1) << (b - 1));
+            const double high = double(quint64(1) << b);
+            return low + (high - low) * (rank - seen) / n;
+        }
+        seen += n;
+    }
+    return double(quint64(1) << (BucketCount - 1));
+}
+
+const char *name(Counter counter)
+{
+    static const char *const names[CounterCount] = {
+        "bytes received", "frames decoded", "parse errors", "snapshots dropped",
+        "camera frames", "camera frames dropped", "video frames dropped", "records dropped",
+        "keyframes dropped"
+    };
+    return names[counter];
+}
+
+const char *name(Histogram histogram)
+{
+    static const char *const names[HistogramCount] = {
+        "parse", "queue depth", "ingest->UI", "capture", "convert", "display", "link delay"
+    };
+    return names[histogram];
+}
+
+bool isDuration(Histogram histogram)
+{
+    return histogram != QueueDepth;
+}
+
+} // namespace Perf
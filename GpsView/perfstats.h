@@ -0,0 +1,61 @@
+#ifndef PERFSTATS_H
+#define PERFSTATS_H
+
+#include <QtGlobal>
+
+// 热路径上的计数器和直方图。
+// 每个线程第一次记录时分配自己的一块统计区，之后只有该线程写，
+// 写入是普通的读-改-写（不带锁前缀），读取时把各线程的统计区加起来，
+// 记录一次的开销只有几纳秒，可以放在每条报文、每一帧上。
+namespace Perf {
+
+enum Counter {
+    BytesReceived,
+    FramesDecoded,
+    ParseErrors,
+    SnapshotsDropped,      // 界面队列满时丢弃的
+    CameraFrames,
+    CameraFramesDropped,   // 界面来不及显示、被新帧覆盖的
+    VideoFramesDropped,    // 录像编码跟不上丢的
+    RecordsDropped,        // 飞行记录队列满丢的
+    KeyframesDropped,      // 关键帧写 JPEG 跟不上时跳过的
+    CounterCount
+};
+
+enum Histogram {
+    ParseTime,             // ns
+    QueueDepth,            // 放入后界面队列中的条数
+    UiApplyLatency,        // ns，解析完成到界面取走
+    CaptureTime,           // ns，cam >> frame
+    ConvertTime,           // ns，生成预览
+    DisplayTime,           // ns，上传纹理或设置 pixmap
+    LinkDelay,             // ns，飞机发出到收到（报文带发送时刻时）
+    HistogramCount
+};
+
+enum { BucketCount = 40 };     // 第 i 个桶为 [2^(i-1), 2^i)，0 单独一个桶
+
+void add(Counter counter, quint64 n = 1);
+void record(Histogram histogram, qint64 value);
+
+// 所有线程的累计值；两次相减得到一段时间内的统计
+struct Snapshot
+{
+    quint64 counters[CounterCount];
+    quint64 buckets[HistogramCount][BucketCount];
+};
+
+Snapshot collect();
+Snapshot difference(const Snapshot &later, const Snapshot &earlier);
+
+quint64 count(const Snapshot &snapshot, Histogram histogram);
+// 按桶内线性插值估算的分位数
+double percentile(const Snapshot &snapshot, Histogram histogram, double p);
+
+const char *name(Counter counter);
+const char *name(Histogram histogram);
+bool isDuration(Histogram histogram);
+
+} // namespace Perf
+
+#endif // PERFSTATS_H
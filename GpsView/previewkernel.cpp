@@ -0,0 +1,188 @@
+#include "previewkernel.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define PREVIEWKERNEL_X86
+#  include <emmintrin.h>
+#  include <immintrin.h>
+#endif
+
+// 两步完成，源图只读一遍：
+//   1. 目标行覆盖的若干源行逐字节纵向累加到 u16 行缓冲（占绝大部分内存访问，SIMD）
+//   2. 行缓冲按列区间横向求和、除以面积并交换 B/R（数据量已缩小为 1/纵向倍数）
+// u16 累加最多容纳 257 行 255，超过时（缩小比例极端）分段累加到 u32 再除。
+
+namespace {
+
+typedef void (*AccumulateRow)(const uchar *src, int bytes, quint16 *acc);
+
+void accumulateScalar(const uchar *src, int bytes, quint16 *acc)
+{
+    for (int i = 0; i < bytes; ++i)
+        acc[i] = quint16(acc[i] + src[i]);
+}
+
+#ifdef PREVIEWKERNEL_X86
+void accumulateSse2(const uchar *src, int bytes, quint16 *acc)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i *a = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(a, _mm_add_epi16(_mm_loadu_si128(a), _mm_unpacklo_epi8(v, zero)));
+        _mm_storeu_si128(a + 1, _mm_add_epi16(_mm_loadu_si128(a + 1), _mm_unpackhi_epi8(v, zero)));
+    }
+    accumulateScalar(src + i, bytes - i, acc + i);
+}
+
+__attribute__((target("avx2")))
+void accumulateAvx2(const uchar *src, int bytes, quint16 *acc)
+{
+    int i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 16));
+        __m256i *a = reinterpret_cast<__m256i *>(acc + i);
+        _mm256_storeu_si256(a, _mm256_add_epi16(_mm256_loadu_si256(a), _mm256_cvtepu8_epi16(lo)));
+        _mm256_storeu_si256(a + 1, _mm256_add_epi16(_mm256_loadu_si256(a + 1), _mm256_cvtepu8_epi16(hi)));
+    }
+    accumulateSse2(src + i, bytes - i, acc + i);
+}
+#endif
+
+PreviewKernel::Implementation bestImplementation()
+{
+#ifdef PREVIEWKERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return PreviewKernel::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return PreviewKernel::SSE2;
+#endif
+    return PreviewKernel::Scalar;
+}
+
+AccumulateRow accumulatorFor(PreviewKernel::Implementation implementation)
+{
+    switch (implementation) {
+#ifdef PREVIEWKERNEL_X86
+    case PreviewKernel::AVX2:
+        return accumulateAvx2;
+    case PreviewKernel::SSE2:
+        return accumulateSse2;
+#endif
+    default:
+        return accumulateScalar;
+    }
+}
+
+} // namespace
+
+namespace PreviewKernel {
+
+bool isSupported(Implementation implementation)
+{
+    static const Implementation best = bestImplementation();
+    return implementation <= best;
+}
+
+const char *name(Implementation implementation)
+{
+    switch (implementation) {
+    case Scalar: return "scalar";
+    case SSE2:   return "SSE2";
+    case AVX2:   return "AVX2";
+    default:     return "auto";
+    }
+}
+
+void fitSize(int srcWidth, int srcHeight, int maxWidth, int maxHeight,
+             int &dstWidth, int &dstHeight)
+{
+    if (srcWidth <= 0 || srcHeight <= 0) {
+        dstWidth = dstHeight = 0;
+        return;
+    }
+    // 宽度受限还是高度受限，用整数比较避免浮点误差
+    if (qint64(maxWidth) * srcHeight <= qint64(maxHeight) * srcWidth) {
+        dstWidth = maxWidth;
+        dstHeight = qMax(1, int(qint64(maxWidth) * srcHeight / srcWidth));
+    } else {
+        dstHeight = maxHeight;
+        dstWidth = qMax(1, int(qint64(maxHeight) * srcWidth / srcHeight));
+    }
+}
+
+void bgrToRgbArea(const uchar *src, int srcWidth, int srcHeight, int srcStride,
+                  uchar *dst, int dstWidth, int dstHeight, int dstStride,
+                  Implementation implementation)
+{
+    static const Implementation best = bestImplementation();
+    if (implementation == Auto || implementation > best)
+        implementation = best;
+    const AccumulateRow accumulate = accumulatorFor(implementation);
+
+    // 采集线程每帧调用，缓冲区按线程复用
+    static thread_local std::vector<quint16> rowSum;
+    static thread_local std::vector<quint32> wideSum;
+    static thread_local std::vector<int> columns;
+
+    const int rowBytes = srcWidth * 3;
+    rowSum.resize(rowBytes);
+    wideSum.resize(rowBytes);
+    columns.resize(dstWidth + 1);
+    for (int x = 0; x <= dstWidth; ++x)
+        columns[x] = int(qint64(x) * srcWidth / dstWidth);
+
+    for (int y = 0; y < dstHeight; ++y) {
+        const int y0 = int(qint64(y) * srcHeight / dstHeight);
+        const int y1 = qMax(y0 + 1, int(qint64(y + 1) * srcHeight / dstHeight));
+        const int rows = y1 - y0;
+
+        // 纵向累加；行数多到 u16 可能溢出时分段并入 u32
+        const bool wide = rows > 257;
+        if (wide)
+            std::fill(wideSum.begin(), wideSum.end(), 0u);
+        for (int r0 = y0; r0 < y1; r0 += 257) {
+            std::fill(rowSum.begin(), rowSum.end(), quint16(0));
+            const int r1 = qMin(y1, r0 + 257);
+            for (int sy = r0; sy < r1; ++sy)
+                accumulate(src + qint64(sy) * srcStride, rowBytes, rowSum.data());
+            if (wide) {
+                for (int i = 0; i < rowBytes; ++i)
+                    wideSum[i] += rowSum[i];
+            }
+        }
+
+        // 横向求和、取平均并交换 B/R
+        uchar *out = dst + qint64(y) * dstStride;
+        for (int x = 0; x < dstWidth; ++x) {
+            const int x0 = columns[x];
+            const int x1 = qMax(x0 + 1, columns[x + 1]);
+
+            quint32 b = 0, g = 0, r = 0;
+            for (int i = x0 * 3; i < x1 * 3; i += 3) {
+                if (wide) {
+                    b += wideSum[i];
+                    g += wideSum[i + 1];
+                    r += wideSum[i + 2];
+                } else {
+                    b += rowSum[i];
+                    g += rowSum[i + 1];
+                    r += rowSum[i + 2];
+                }
+            }
+
+            const quint32 area = quint32(rows * (x1 - x0));
+            out[0] = uchar((r + area / 2) / area);
+            out[1] = uchar((g + area / 2) / area);
+            out[2] = uchar((b + area / 2) / area);
+            out += 3;
+        }
+    }
+}
+
+} // namespace PreviewKernel
@@ -0,0 +1,31 @@
+#ifndef PREVIEWKERNEL_H
+#define PREVIEWKERNEL_H
+
+#include <QtGlobal>
+
+// 摄像头预览：BGR 原始帧一次遍历完成 BGR->RGB 和区域平均缩小
+namespace PreviewKernel {
+
+enum Implementation {
+    Auto,       // 按 CPU 支持选择最快的
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+bool isSupported(Implementation implementation);
+const char *name(Implementation implementation);
+
+// 等比缩放到 maxWidth x maxHeight 以内（同 Qt::KeepAspectRatio）
+void fitSize(int srcWidth, int srcHeight, int maxWidth, int maxHeight,
+             int &dstWidth, int &dstHeight);
+
+// src 为 BGR888，dst 为 RGB888；每个目标像素取其覆盖的源像素块的平均值，
+// 放大时退化为最近邻。各实现的输出逐字节相同
+void bgrToRgbArea(const uchar *src, int srcWidth, int srcHeight, int srcStride,
+                  uchar *dst, int dstWidth, int dstHeight, int dstStride,
+                  Implementation implementation = Auto);
+
+} // namespace PreviewKernel
+
+#endif // PREVIEWKERNEL_H
@@ -0,0 +1,320 @@
+#include "replaysource.h"
+#include "flightrecorder.h"
+#include "telemetrybinary.h"
+
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+
+ReplaySource::ReplaySource(QObject *parent)
+    : QObject(parent),
+      data(0),
+      size(0),
+      wallStartMs(0),
+      monotonicStartNs(0),
+      startNs(0),
+      endNs(0),
+      cursor(0),
+      cursorNs(0),
+      sample(),
+      playSpeed(1.0)
+{
+    tickTimer.setInterval(TickInterval);
+    tickTimer.setTimerType(Qt::PreciseTimer);
+    connect(&tickTimer, &QTimer::timeout, this, &ReplaySource::tick);
+}
+
+ReplaySource::~ReplaySource()
+{
+    close();
+}
+
+bool ReplaySource::open(const QString &fileName)
+{
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    size = file.size();
+    data = size >= FlightRecorder::FileHeaderSize ? file.map(0, size) : 0;
+    if (!data || memcmp(data, "GVFR", 4) != 0
+            || qFromLittleEndian<quint32>(data + 4) > quint32(FlightRecorder::Version)) {
+        error = data ? tr("Not a flight record") : file.errorString();
+        close();
+        return false;
+    }
+    wallStartMs = qFromLittleEndian<qint64>(data + 8);
+    monotonicStartNs = qFromLittleEndian<qint64>(data + 16);
+
+    buildIndex();
+    if (index.isEmpty()) {
+        error = tr("Flight record is empty");
+        close();
+        return false;
+    }
+
+    // 第一条记录所属的飞机
+    const uchar *frame = data + index[0].offset + FlightRecorder::RecordHeaderSize;
+    droneId = QByteArray(reinterpret_cast<const char *>(frame) + TelemetryBinary::HeaderSize, frame[3]);
+
+    cursorNs = startNs;
+    cursor = index[0].offset;
+    sample = TelemetrySample();
+    return true;
+}
+
+void ReplaySource::close()
+{
+    tickTimer.stop();
+    if (data)
+        file.unmap(const_cast<uchar *>(data));
+    data = 0;
+    size = 0;
+    file.close();
+    index.clear();
+    startNs = endNs = cursorNs = 0;
+    cursor = 0;
+}
+
+// offset 处是否是一条完整的记录；checkFrame 时还要求帧内容能解码，用于重新对齐
+bool ReplaySource::recordAt(qint64 offset, qint64 &timeNs, int &length, bool checkFrame) const
+{
+    if (offset < FlightRecorder::FileHeaderSize || offset + FlightRecorder::RecordHeaderSize > size)
+        return false;
+
+    const uchar *p = data + offset;
+    length = qFromLittleEndian<quint16>(p);
+    if (length < TelemetryBinary::HeaderSize || length > TelemetryBinary::MaxFrameSize
+            || offset + FlightRecorder::RecordHeaderSize + length > size)
+        return false;
+
+    if (checkFrame) {
+        TelemetrySample scratch;
+        TelemetryParser::Result result;
+        if (!TelemetryBinary::decode(reinterpret_cast<const char *>(p) + FlightRecorder::RecordHeaderSize,
+                                     length, scratch, result))
+            return false;
+    }
+
+    timeNs = qFromLittleEndian<qint64>(p + 2);
+    return true;
+}
+
+// 从任意位置找到下一条记录的开头：连续三条记录都能解析才算对齐
+qint64 ReplaySource::resync(qint64 offset) const
+{
+    for (; offset + FlightRecorder::RecordHeaderSize <= size; ++offset) {
+        qint64 at = offset, timeNs, previousNs = 0;
+        int length, valid = 0;
+        while (valid < 3 && recordAt(at, timeNs, length, true) && (valid == 0 || timeNs >= previousNs)) {
+            previousNs = timeNs;
+            at += FlightRecorder::RecordHeaderSize + length;
+            ++valid;
+        }
+        // 文件末尾不足三条时，能一直解析到结尾也算
+        if (valid == 3 || (valid > 0 && at == size))
+            return offset;
+    }
+    return -1;
+}
+
+void ReplaySource::buildIndex()
+{
+    qint64 timeNs;
+    int length;
+    for (qint64 at = FlightRecorder::FileHeaderSize; at < size; at += IndexStride) {
+        const qint64 offset = at == FlightRecorder::FileHeaderSize ? at : resync(at);
+        if (offset < 0 || !recordAt(offset, timeNs, length, true))
+            break;
+        if (!index.isEmpty() && (offset <= index.last().offset || timeNs < index.last().timeNs))
+            continue;
+        IndexEntry entry = { timeNs, offset };
+        index.append(entry);
+    }
+    if (index.isEmpty())
+        return;
+
+    // 结束时间：从最后一个索引点走到文件末尾（记录中断时停在最后一条完整记录）
+    startNs = index.first().timeNs;
+    endNs = index.last().timeNs;
+    for (qint64 at = index.last().offset; recordAt(at, timeNs, length);
+         at += FlightRecorder::RecordHeaderSize + length)
+        endNs = timeNs;
+}
+
+// 第一条时间晚于 timeNs 的记录的位置
+qint64 ReplaySource::offsetFor(qint64 timeNs) const
+{
+    IndexEntry key = { timeNs, 0 };
+    QVector<IndexEntry>::const_iterator it = std::upper_bound(
+                index.begin(), index.end(), key,
+                [](const IndexEntry &a, const IndexEntry &b) { return a.timeNs < b.timeNs; });
+    if (it != index.begin())
+        --it;
+
+    qint64 at = it->offset, t;
+    int length;
+    while (recordAt(at, t, length) && t <= timeNs)
+        at += FlightRecorder::RecordHeaderSize + length;
+    return at;
+}
+
+// 只看帧头：是不是回放的飞机，带了哪些部分
+bool ReplaySource::isReplayedDrone(qint64 offset, int length, quint32 &sections) const
+{
+    const uchar *frame = data + offset + FlightRecorder::RecordHeaderSize;
+    const int idLength = frame[3];
+    if (TelemetryBinary::HeaderSize + idLength > length)
+        return false;
+
+    sections = frame[2];
+    return idLength == droneId.size()
+            && memcmp(frame + TelemetryBinary::HeaderSize, droneId.constData(), idLength) == 0;
+}
+
+// 解码一条记录，合并到回放状态；不是回放的飞机时返回 false
+bool ReplaySource::decodeAt(qint64 offset)
+{
+    const char *p = reinterpret_cast<const char *>(data + offset);
+    const int length = qFromLittleEndian<quint16>(data + offset);
+    const qint64 timeNs = qFromLittleEndian<qint64>(data + offset + 2);
+
+    TelemetrySample decoded = sample;
+    TelemetryParser::Result result;
+    quint32 sequence;
+    if (!TelemetryBinary::decode(p + FlightRecorder::RecordHeaderSize, length, decoded, result, &sequence)
+            || QByteArray::fromRawData(result.droneId, result.droneIdLength) != droneId)
+        return false;
+
+    decoded.sections |= result.sections;
+    decoded.sequence = sequence;
+    decoded.timestampNs = timeNs;
+    decoded.sentMs = double(qFromLittleEndian<qint64>(data + offset + 10));
+    sample = decoded;
+    return true;
+}
+
+// 日志文本只为真正输出的状态生成
+void ReplaySource::fillSnapshot(TelemetrySnapshot &snapshot) const
+{
+    snapshot.sample = sample;
+    snapshot.link = LinkStats();
+    snapshot.receivedMs = wallStartMs + (sample.timestampNs - monotonicStartNs) / 1000000;
+    snapshot.message = QString("[replay] lng %1 lat %2 alt %3 bat %4%")
+            .arg(sample.longitude, 0, 'f', 7).arg(sample.latitude, 0, 'f', 7)
+            .arg(sample.altitude, 0, 'f', 1).arg(sample.batteryPercent);
+}
+
+void ReplaySource::play()
+{
+    if (!isOpen() || isPlaying())
+        return;
+    if (cursorNs >= endNs)
+        seek(0);
+    clock.start();
+    tickTimer.start();
+}
+
+void ReplaySource::pause()
+{
+    tickTimer.stop();
+}
+
+void ReplaySource::setSpeed(double speed)
+{
+    playSpeed = qBound(0.01, speed, 1000.0);
+}
+
+void ReplaySource::seek(qint64 positionNs)
+{
+    if (!isOpen())
+        return;
+    emit seeked();
+
+    cursorNs = startNs + qBound(Q_INT64_C(0), positionNs, durationNs());
+    cursor = offsetFor(cursorNs);
+
+    // 状态取目标时刻之前最近的一条，往回找这架飞机的记录代价太大，
+    // 这里从所在索引点开始顺序扫描，最多一个索引间隔。扫描只读帧头，
+    // 记下各部分最后出现的记录，最后只解码这几条
+    IndexEntry key = { cursorNs, 0 };
+    QVector<IndexEntry>::const_iterator it = std::upper_bound(
+                index.begin(), index.end(), key,
+                [](const IndexEntry &a, const IndexEntry &b) { return a.timeNs < b.timeNs; });
+    if (it != index.begin())
+        --it;
+
+    qint64 latest[4] = { -1, -1, -1, -1 };     // GPS、Gimbal、Battery 各自最后一条，以及最后一条
+    qint64 t;
+    int length;
+    for (qint64 at = it->offset; at < cursor && recordAt(at, t, length);
+         at += FlightRecorder::RecordHeaderSize + length) {
+        quint32 sections;
+        if (!isReplayedDrone(at, length, sections))
+            continue;
+        for (int i = 0; i < 3; ++i) {
+            if (sections & (1u << i))
+                latest[i] = at;
+        }
+        latest[3] = at;
+    }
+
+    // 按文件顺序解码，最后一条最后解码，序号和时刻取自它
+    sample = TelemetrySample();
+    std::sort(latest, latest + 4);
+    bool found = false;
+    for (int i = 0; i < 4; ++i) {
+        if (latest[i] >= 0 && (i == 0 || latest[i] != latest[i - 1]))
+            found = decodeAt(latest[i]) || found;
+    }
+
+    if (found) {
+        TelemetrySnapshot snapshot;
+        fillSnapshot(snapshot);
+        emit snapshotsReady(QVector<TelemetrySnapshot>() << snapshot);
+    }
+    emit positionChanged(positionNs());
+    clock.restart();
+}
+
+void ReplaySource::tick()
+{
+    // 按真实流逝的时间乘以倍速推进，定时器抖动不会累积
+    const qint64 elapsedNs = clock.nsecsElapsed();
+    clock.restart();
+    const qint64 targetNs = qMin(endNs, cursorNs + qint64(elapsedNs * playSpeed));
+
+    // 先找出这段时间内的记录范围，太多时只输出最后 MaxBatch 条
+    QVector<qint64> offsets;
+    qint64 at = cursor, t;
+    int length;
+    while (recordAt(at, t, length) && t <= targetNs) {
+        offsets.append(at);
+        at += FlightRecorder::RecordHeaderSize + length;
+    }
+    cursor = at;
+    cursorNs = targetNs;
+
+    QVector<TelemetrySnapshot> batch;
+    batch.reserve(qMin(offsets.size(), int(MaxBatch)));
+    TelemetrySnapshot snapshot;
+    for (int i = qMax(0, offsets.size() - MaxBatch); i < offsets.size(); ++i) {
+        if (decodeAt(offsets[i])) {
+            fillSnapshot(snapshot);
+            batch.append(snapshot);
+        }
+    }
+
+    if (!batch.isEmpty())
+        emit snapshotsReady(batch);
+    emit positionChanged(positionNs());
+
+    if (cursorNs >= endNs) {
+        pause();
+        emit finished();
+    }
+}
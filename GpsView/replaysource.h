@@ -0,0 +1,96 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <QObject>
+#include <QFile>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "telemetryingest.h"
+
+// 回放 FlightRecorder 记录的文件，输出与实时接收相同的 TelemetrySnapshot。
+// 文件整个映射到内存，打开时只按固定字节间隔取样建立稀疏时间索引，
+// 不读完整个文件，几 GB 的记录也能立即打开；定位时先在索引中二分查找，
+// 再从索引点向后顺序扫描不超过一个间隔。
+//
+// 文件中有多架飞机时只回放第一条记录所属的飞机。
+class ReplaySource : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ReplaySource(QObject *parent = 0);
+    ~ReplaySource();
+
+    // 打开后停在开头但不输出状态，需要时调用 seek(0)
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return data != 0; }
+    QString errorString() const { return error; }
+
+    qint64 startTimeNs() const { return startNs; }     // Telemetry::monotonicNs() 时钟
+    qint64 durationNs() const { return endNs - startNs; }
+    qint64 positionNs() const { return cursorNs - startNs; }
+    bool isPlaying() const { return tickTimer.isActive(); }
+    double speed() const { return playSpeed; }
+
+    void play();
+    void pause();
+    void setSpeed(double speed);
+    // 跳到相对开始的 positionNs，并立即输出该时刻的状态
+    void seek(qint64 positionNs);
+
+signals:
+    // 每次推进输出一批，按时间顺序
+    void snapshotsReady(const QVector<TelemetrySnapshot> &snapshots);
+    void positionChanged(qint64 positionNs);
+    // seek() 开始时发出，之后输出的状态和时刻与之前的不连续
+    void seeked();
+    void finished();
+
+private:
+    enum {
+        IndexStride = 1 << 20,     // 每 1 MB 一个索引点
+        TickInterval = 16,         // ms
+        MaxBatch = 5000            // 每次最多输出的条数，高倍速时跳过中间的
+    };
+
+    struct IndexEntry
+    {
+        qint64 timeNs;
+        qint64 offset;
+    };
+
+    bool recordAt(qint64 offset, qint64 &timeNs, int &length, bool checkFrame = false) const;
+    qint64 resync(qint64 offset) const;
+    void buildIndex();
+    qint64 offsetFor(qint64 timeNs) const;
+    bool isReplayedDrone(qint64 offset, int length, quint32 &sections) const;
+    bool decodeAt(qint64 offset);
+    void fillSnapshot(TelemetrySnapshot &snapshot) const;
+    void tick();
+
+    QFile file;
+    const uchar *data;
+    qint64 size;
+    QString error;
+
+    qint64 wallStartMs;            // 文件头：开始记录时的墙上时间和单调时钟
+    qint64 monotonicStartNs;
+    QByteArray droneId;            // 回放的飞机
+
+    QVector<IndexEntry> index;
+    qint64 startNs;
+    qint64 endNs;
+
+    qint64 cursor;                 // 下一条要输出的记录
+    qint64 cursorNs;               // 当前回放到的时刻
+    TelemetrySample sample;        // 回放出的累计状态
+
+    double playSpeed;
+    QTimer tickTimer;
+    QElapsedTimer clock;
+};
+
+#endif // REPLAYSOURCE_H
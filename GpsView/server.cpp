@@ -1,4 +1,11 @@
 #include "server.h"
+#include "telemetryingest.h"
+#include "logmodel.h"
+#include "flightrecorder.h"
+#include "replaysource.h"
+#include "perfstats.h"
+#include "perfpanel.h"
+#include "trace.h"
 
 
 namespace Ui {
@@ -22,6 +29,21 @@ Server::Server(QWidget* parent)
         upper_button_layout->addWidget(ifHostIp);
         connect(ifHostIp, &QCheckBox::stateChanged, this, &Server::responseToCheckBox);
 
+        transportSelect = new QComboBox(this);
+        transportSelect->addItem(tr("TCP"), int(TelemetryIngest::Tcp));
+        transportSelect->addItem(tr("UDP"), int(TelemetryIngest::Udp));
+        upper_button_layout->addWidget(transportSelect);
+
+        portSelect = new QSpinBox(this);
+        portSelect->setRange(1, 65535);
+        portSelect->setValue(6666);
+        upper_button_layout->addWidget(portSelect);
+
+        droneSelect = new QComboBox(this);
+        droneSelect->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+        upper_button_layout->addWidget(droneSelect);
+        connect(droneSelect, &QComboBox::currentTextChanged, this, &Server::selectDrone);
+
 
         QHBoxLayout* lower_button_layout = new QHBoxLayout();
 
@@ -33,25 +55,137 @@ Server::Server(QWidget* parent)
         connect(clear_button, &QPushButton::released, this, &Server::clear);
         lower_button_layout->addWidget(clear_button);
 
-        grid->addLayout(lower_button_layout, 1, 0, Qt::AlignLeft);
+        recordButton = new QPushButton(tr("Record"), this);
+        recordButton->setCheckable(true);
+        connect(recordButton, &QPushButton::toggled, this, &Server::toggleRecording);
+        lower_button_layout->addWidget(recordButton);
 
-        grid->addLayout(upper_button_layout, 0, 0, Qt::AlignLeft);
+        QPushButton* keyframe_button = new QPushButton(tr("Keyframes"), this);
+        keyframe_button->setCheckable(true);
+        connect(keyframe_button, &QPushButton::toggled, this, &Server::toggleKeyframes);
+        lower_button_layout->addWidget(keyframe_button);
+
+        QPushButton* stats_button = new QPushButton(tr("Stats"), this);
+        stats_button->setCheckable(true);
+        lower_button_layout->addWidget(stats_button);
 
-        textEdit = new QTextEdit(this);
-        textEdit->setObjectName(QStringLiteral("textEdit"));
-        textEdit->setReadOnly(true);
-        grid->addWidget(textEdit, 2, 0, 1, 2);
+        QPushButton* trace_button = new QPushButton(tr("Trace"), this);
+        trace_button->setCheckable(true);
+        connect(trace_button, &QPushButton::toggled, this, &Server::toggleTrace);
+        lower_button_layout->addWidget(trace_button);
 
-        connect(&tcpServer, &QTcpServer::newConnection,
-                this, &Server::acceptConnection);
+        linkLabel = new QLabel(this);
+        lower_button_layout->addWidget(linkLabel);
 
+        grid->addLayout(lower_button_layout, 1, 0, Qt::AlignLeft);
+
+        grid->addLayout(upper_button_layout, 0, 0, Qt::AlignLeft);
+
+        // 回放：打开记录文件后界面由回放数据驱动，实时数据暂不显示
+        QHBoxLayout* replay_layout = new QHBoxLayout();
+
+        replayButton = new QPushButton(tr("Replay"), this);
+        replayButton->setCheckable(true);
+        connect(replayButton, &QPushButton::toggled, this, &Server::toggleReplay);
+        replay_layout->addWidget(replayButton);
+
+        playButton = new QPushButton(tr("Play"), this);
+        playButton->setCheckable(true);
+        playButton->setEnabled(false);
+        replay_layout->addWidget(playButton);
+
+        speedSelect = new QComboBox(this);
+        const int speeds[] = { 1, 2, 5, 10, 20, 50, 100 };
+        for (int speed : speeds)
+            speedSelect->addItem(QString("%1x").arg(speed), speed);
+        replay_layout->addWidget(speedSelect);
+
+        replaySlider = new QSlider(Qt::Horizontal, this);
+        replaySlider->setEnabled(false);
+        replay_layout->addWidget(replaySlider, 1);
+
+        replayLabel = new QLabel(this);
+        replay_layout->addWidget(replayLabel);
+
+        grid->addLayout(replay_layout, 2, 0);
+
+        logModel = new LogModel(5000, 10, this);
+        logView = new QListView(this);
+        logView->setObjectName(QStringLiteral("logView"));
+        logView->setModel(logModel);
+        logView->setUniformItemSizes(true);
+        logView->setWordWrap(false);
+        logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        grid->addWidget(logView, 3, 0, 1, 2);
+
+        perfPanel = new PerfPanel(this);
+        perfPanel->hide();
+        connect(stats_button, &QPushButton::toggled, perfPanel, &QWidget::setVisible);
+        grid->addWidget(perfPanel, 4, 0, 1, 2);
+
+        //自动滚动到最底，用户往上翻时暂停
+        followLog = true;
+        connect(logView->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int value) {
+            followLog = value == logView->verticalScrollBar()->maximum();
+        });
+        connect(logModel, &QAbstractItemModel::rowsInserted, this, [this]() {
+            if (followLog)
+                logView->scrollToBottom();
+        });
+
+    recorder = new FlightRecorder(this);
+    connect(recorder, &FlightRecorder::recordingFailed, this, [this](const QString &error) {
+        recordButton->setChecked(false);
+        QMessageBox::warning(this, tr("Record"), error);
+    });
+
+    replay = new ReplaySource(this);
+    connect(replay, &ReplaySource::snapshotsReady, this, &Server::applyReplay);
+    connect(replay, &ReplaySource::positionChanged, this, &Server::showReplayPosition);
+    connect(replay, &ReplaySource::seeked, this, &Server::replaySeeked);
+    connect(replay, &ReplaySource::finished, this, [this]() {
+        playButton->setChecked(false);
+    });
+    connect(playButton, &QPushButton::toggled, this, [this](bool on) {
+        if (on)
+            replay->play();
+        else
+            replay->pause();
+        playButton->setText(on ? tr("Pause") : tr("Play"));
+    });
+    connect(speedSelect, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, [this]() {
+        replay->setSpeed(speedSelect->currentData().toDouble());
+    });
+    // 拖动时按 0.1 秒定位
+    connect(replaySlider, &QSlider::valueChanged, this, [this](int value) {
+        replay->seek(qint64(value) * 100000000);
+    });
+
+    ingest = new TelemetryIngest;
+    ingest->setRecorder(recorder);
+    ingest->moveToThread(&ingestThread);
+    connect(&ingestThread, &QThread::finished, ingest, &QObject::deleteLater);
+    connect(ingest, &TelemetryIngest::snapshotsReady, this, &Server::drainSnapshots);
+    connect(ingest, &TelemetryIngest::sessionsChanged, this, &Server::updateDroneList);
+    connect(ingest, &TelemetryIngest::listenFailed, this, [this](const QString &) {
+        close();
+    });
+    ingestThread.setObjectName("ingest");
+    ingestThread.start();
 
     totalBytes = 0;
+    telemetry = TelemetrySample();
 
 }
 
+Server::~Server()
+{
+    ingestThread.quit();
+    ingestThread.wait();
+}
+
 void Server::clear(){
-    textEdit->clear();
+    logModel->clear();
 }
 
 void Server::responseToCheckBox()
@@ -72,69 +206,181 @@ void Server::responseToCheckBox()
 
 void Server::startListening()
 {
-    //   if (!tcpServer.listen(QHostAddress::LocalHost, 6666)) {
-     if (!tcpServer.listen(QHostAddress(setIpAddress->text()), 6666)) {
-           qDebug() << tcpServer.errorString();
-           close();
-           return;
-       }
+    //   监听在网络线程中进行
+    QMetaObject::invokeMethod(ingest, "listen", Qt::QueuedConnection,
+                              Q_ARG(QString, setIpAddress->text()),
+                              Q_ARG(int, portSelect->value()),
+                              Q_ARG(int, transportSelect->currentData().toInt()));
 }
 
-void Server::acceptConnection()
+// 记录文件放在程序目录的 records 下，按开始时间命名；录像使用同一个文件名
+void Server::toggleRecording(bool on)
 {
-    tcpServerConnection = tcpServer.nextPendingConnection();
-    connect(tcpServerConnection, &QTcpSocket::readyRead,
-            this, &Server::updateServerProgress);
-//    connect(tcpServerConnection, SIGNAL(error(QAbstractSocket::SocketError)),
-//            this, SLOT(displayError(QAbstractSocket::SocketError)));
-  //  ui->serverStatusLabel->setText(tr("接受连接"));
-  //  关闭服务器，不再进行监听
-  //  tcpServer.close();
+    if (!on) {
+        recorder->stopRecording();
+        emit recordingStopped();
+        return;
+    }
+
+    const QString dir = qApp->applicationDirPath() + "/records";
+    QDir().mkpath(dir);
+    const QString baseName = dir + "/flight-"
+            + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+    if (!recorder->startRecording(baseName + ".gvfr")) {
+        QMessageBox::warning(this, tr("Record"), recorder->errorString());
+        recordButton->setChecked(false);
+        return;
+    }
+    emit recordingStarted(baseName);
 }
 
-void Server::updateServerProgress()
+// 按下开始跟踪，抬起时把各线程最近的事件写成 Chrome trace 文件
+void Server::toggleTrace(bool on)
 {
-    QDateTime time = QDateTime::currentDateTime();
-    QString str = time.toString("\n[ hh:mm:ss ]"); //设置显示格式
-    qDebug()<<str;
+    Trace::setEnabled(on);
+    if (on)
+        return;
+
+    const QString dir = qApp->applicationDirPath() + "/records";
+    QDir().mkpath(dir);
+    const QString fileName = dir + "/trace-"
+            + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".json";
+    if (Trace::dump(fileName))
+        logModel->append(QDateTime::currentMSecsSinceEpoch(), tr("trace written to %1").arg(fileName));
+    else
+        QMessageBox::warning(this, tr("Trace"), tr("Can't write %1").arg(fileName));
+}
 
-    qint64 len = tcpServerConnection->bytesAvailable();
-    qDebug()<<"socket data len:"<< len;
-    QByteArray alldata = tcpServerConnection->read(len);
-    //开始转换编码
-    QTextCodec *utf8codec = QTextCodec::codecForName("UTF-8");
-    QString utf8str = utf8codec->toUnicode(alldata.mid(2));
-   // qDebug()<<"hex:["<<alldata.toHex().toUpper()<<"]";
-    qDebug()<<"utf-8 ["<< (utf8str) << "]";
+// 按下期间从实时画面中挑关键帧，写到 records 下按开始时间命名的目录
+void Server::toggleKeyframes(bool on)
+{
+    if (!on) {
+        emit keyframeCaptureStopped();
+        return;
+    }
 
+    const QString dir = qApp->applicationDirPath() + "/records/keyframes-"
+            + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+    logModel->append(QDateTime::currentMSecsSinceEpoch(), tr("keyframes go to %1").arg(dir));
+    emit keyframeCaptureStarted(dir);
+}
 
-    json = getJsonObjectFromString(utf8str);
+void Server::toggleReplay(bool on)
+{
+    playButton->setChecked(false);
+    if (!on) {
+        replay->close();
+        playButton->setEnabled(false);
+        replaySlider->setEnabled(false);
+        replayLabel->clear();
+        emit replayClosed();
+        return;
+    }
 
-    if(json.contains("GPS")){
-        jsonGPS = json["GPS"].toObject();
-//        qDebug()<<"\n->"<< jsonGPS["altitude"].toDouble();
+    const QString fileName = QFileDialog::getOpenFileName(
+                this, tr("Open flight record"), qApp->applicationDirPath() + "/records",
+                tr("Flight records (*.gvfr)"));
+    if (fileName.isEmpty() || !replay->open(fileName)) {
+        if (!fileName.isEmpty())
+            QMessageBox::warning(this, tr("Replay"), replay->errorString());
+        replayButton->setChecked(false);
+        return;
     }
 
-    if(json.contains("Gimbal")){
-        jsonGimbal = json["Gimbal"].toObject();
+    replay->setSpeed(speedSelect->currentData().toDouble());
+    replaySlider->blockSignals(true);
+    replaySlider->setRange(0, int(replay->durationNs() / 100000000));
+    replaySlider->blockSignals(false);
+    replaySlider->setEnabled(true);
+    playButton->setEnabled(true);
+    // 先通知回放开始，界面切到回放状态后再输出开头的状态
+    emit replayOpened(fileName);
+    replay->seek(0);
+}
+
+void Server::showReplayPosition(qint64 positionNs)
+{
+    replaySlider->blockSignals(true);
+    replaySlider->setValue(int(positionNs / 100000000));
+    replaySlider->blockSignals(false);
+
+    const QTime zero(0, 0);
+    replayLabel->setText(QString("%1 / %2")
+                         .arg(zero.addMSecs(int(positionNs / 1000000)).toString("HH:mm:ss"))
+                         .arg(zero.addMSecs(int(replay->durationNs() / 1000000)).toString("HH:mm:ss")));
+    emit replayTimeChanged(replay->startTimeNs() + positionNs);
+}
+
+// 回放数据走与实时数据相同的路径
+void Server::applyReplay(const QVector<TelemetrySnapshot> &snapshots)
+{
+    for (int i = 0; i < snapshots.size(); ++i)
+        applySnapshot(snapshots[i]);
+    linkLabel->setText(tr("replay"));
+    emit telemetryChanged();
+}
+
+// 飞机列表和当前飞机都以网络线程为准，这里只做显示
+void Server::updateDroneList(const QStringList &ids, const QString &activeId)
+{
+    droneSelect->blockSignals(true);
+    droneSelect->clear();
+    droneSelect->addItems(ids);
+    droneSelect->setCurrentIndex(ids.indexOf(activeId));
+    droneSelect->blockSignals(false);
+}
+
+void Server::selectDrone(const QString &id)
+{
+    QMetaObject::invokeMethod(ingest, "setActiveDrone", Qt::QueuedConnection,
+                              Q_ARG(QString, id));
+}
+
+void Server::drainSnapshots()
+{
+    Trace::Span span("drain snapshots");
+
+    // 先重新允许通知再取数据，保证取数期间新到的报文不会被漏掉
+    ingest->rearmNotify();
+
+    TelemetrySnapshot snapshot;
+    bool any = false;
+    while (ingest->takeSnapshot(snapshot)) {
+        if (replay->isOpen())
+            continue;       // 回放期间实时数据照常取走，只是不显示
+        Perf::record(Perf::UiApplyLatency, Telemetry::monotonicNs() - snapshot.sample.timestampNs);
+        applySnapshot(snapshot);
+        any = true;
     }
-    if(json.contains("Battery")){
-        jsonBattery = json["Battery"].toObject();
+
+    // 链路统计和界面通知每批只有一次
+    if (any) {
+        showLinkStats(snapshot.link);
+        emit telemetryChanged();
     }
+}
 
-    //显示到控件上
-    textEdit->insertPlainText(str);//在标签上显示时间
-    textEdit->insertPlainText(utf8str);
-    textEdit->insertPlainText(tr("\n"));
+void Server::showLinkStats(const LinkStats &link)
+{
+    QString text = tr("rx %1").arg(link.received);
+    if (link.lost || link.reordered || link.duplicates) {
+        text += tr("  lost %1  late %2  dup %3")
+                .arg(link.lost).arg(link.reordered).arg(link.duplicates);
+    }
+    linkLabel->setText(text);
+}
 
+void Server::applySnapshot(const TelemetrySnapshot &snapshot)
+{
+    Trace::Span span("apply snapshot", snapshot.sample.sequence);
+    telemetry = snapshot.sample;
+    emit sampleReceived(telemetry);
 
-    //自动滚动到最底
-    scrollbar = textEdit->verticalScrollBar();
-    if (scrollbar)
-    {
-       scrollbar->setSliderPosition(scrollbar->maximum());
-    }
+    if (snapshot.message.isEmpty())
+        return;
 
+    //显示到控件上，按固定频率批量刷新
+    logModel->append(snapshot.receivedMs, snapshot.message);
 }
 
 //void Server::displayError(QAbstractSocket::SocketError socketError)
@@ -146,13 +392,4 @@ void Server::updateServerProgress()
 
 //}
 
-QJsonObject Server::getJsonObjectFromString(const QString jsonString){
-    QJsonDocument jsonDocument = QJsonDocument::fromJson(jsonString.toLocal8Bit().data());
-    if( jsonDocument.isNull() ){
-        qDebug()<< "===> please check the string "<< jsonString.toLocal8Bit().data();
-    }
-    QJsonObject jsonObject = jsonDocument.object();
-    return jsonObject;
-}
-
 } //namespce Ui
@@ -7,44 +7,85 @@
 #include <QScrollBar>
 #include <QMessageBox>
 
-#include <QJsonDocument>
-#include <QJsonObject>
+#include "telemetrysample.h"
 
 #include <QtWidgets>
 #include <QtNetwork>
 
 
-class QTcpSocket;
+class TelemetryIngest;
+struct TelemetrySnapshot;
+struct LinkStats;
+class LogModel;
+class FlightRecorder;
+class ReplaySource;
+class PerfPanel;
 
 namespace Ui{
 class MainWindow;
 
 class Server : public QWidget
 {
+    Q_OBJECT
 
 public:
     Server(QWidget* parent);
-    QJsonObject json, jsonGPS, jsonGimbal, jsonBattery;
+    ~Server();
+    TelemetrySample telemetry;     // 当前飞机最近一次的遥测
+
+signals:
+    void telemetryChanged();       // 每批新数据只发一次
+    void sampleReceived(const TelemetrySample &sample);    // 每条报文一次
+    void recordingStarted(const QString &baseName);        // 记录文件的路径，不含扩展名
+    void recordingStopped();
+    void replayOpened(const QString &fileName);
+    void replayClosed();
+    void replaySeeked();                                   // 紧接着输出跳转处的状态
+    void replayTimeChanged(qint64 timeNs);                 // 回放到的记录时刻，monotonicNs 时钟
+    void keyframeCaptureStarted(const QString &directory);
+    void keyframeCaptureStopped();
 private:
 
-    QTcpServer tcpServer;
-    QTcpSocket *tcpServerConnection;
+    QThread ingestThread;          // 网络线程：监听、拆帧、解析都在这里
+    TelemetryIngest *ingest;
+    FlightRecorder *recorder;      // 飞行记录，写文件在它自己的线程中
+    ReplaySource *replay;          // 打开记录文件时代替实时数据
     qint64 totalBytes;     // 存放总大小信息
     QString fileName;      // 存放文件名
-    QByteArray inBlock;    // 数据缓冲区
-    QScrollBar *scrollbar;
 
-    QTextEdit *textEdit;
-    QJsonObject getJsonObjectFromString(const QString jsonString);
+    QListView *logView;
+    LogModel *logModel;
+    bool followLog;                // 日志停在底部时自动跟随新条目
 
     QCheckBox *ifHostIp;
     QLineEdit *setIpAddress;
+    QComboBox *transportSelect;
+    QSpinBox *portSelect;
+    QComboBox *droneSelect;
+    QLabel *linkLabel;
+    QPushButton *recordButton;
+    PerfPanel *perfPanel;          // 性能统计，Stats 按钮切换显示
+
+    QPushButton *replayButton;
+    QPushButton *playButton;
+    QComboBox *speedSelect;
+    QSlider *replaySlider;
+    QLabel *replayLabel;
 
 
     void responseToCheckBox();
     void startListening();
-    void updateServerProgress();
-    void acceptConnection();
+    void toggleRecording(bool on);
+    void toggleTrace(bool on);
+    void toggleKeyframes(bool on);
+    void toggleReplay(bool on);
+    void showReplayPosition(qint64 positionNs);
+    void applyReplay(const QVector<TelemetrySnapshot> &snapshots);
+    void drainSnapshots();
+    void applySnapshot(const TelemetrySnapshot &snapshot);
+    void showLinkStats(const LinkStats &link);
+    void updateDroneList(const QStringList &ids, const QString &activeId);
+    void selectDrone(const QString &id);
     void clear();
 
   //  void displayError(QAbstractSocket::SocketError socketError);
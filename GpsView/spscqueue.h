@@ -0,0 +1,47 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicInteger>
+
+// 单生产者/单消费者无锁环形队列。
+// push() 只能在生产者线程调用，pop() 只能在消费者线程调用；
+// 队列满时 push() 直接返回 false，生产者永远不会被消费者阻塞。
+template <typename T, int Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    bool push(const T &value)
+    {
+        const quint32 h = head.load();
+        if (h - tail.loadAcquire() == quint32(Capacity))
+            return false;
+        cells[h & (Capacity - 1)] = value;
+        head.storeRelease(h + 1);
+        return true;
+    }
+
+    bool pop(T &value)
+    {
+        const quint32 t = tail.load();
+        if (head.loadAcquire() == t)
+            return false;
+        value = cells[t & (Capacity - 1)];
+        tail.storeRelease(t + 1);
+        return true;
+    }
+
+    int size() const { return int(head.loadAcquire() - tail.loadAcquire()); }
+
+private:
+    // head 和 tail 分别由两个线程写，放在不同的缓存行上避免伪共享；
+    // 无符号计数回绕后差值依然正确
+    alignas(64) QAtomicInteger<quint32> head;
+    alignas(64) QAtomicInteger<quint32> tail;
+    alignas(64) T cells[Capacity];
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,157 @@
+#include "telemetrybinary.h"
+
+#include <cmath>
+#include <cstring>
+
+
+namespace {
+
+inline quint32 readU32(const uchar *p)
+{
+    return quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+}
+
+inline qint32 readI32(const uchar *p)
+{
+    return qint32(readU32(p));
+}
+
+inline qint16 readI16(const uchar *p)
+{
+    return qint16(quint16(p[0]) | quint16(p[1]) << 8);
+}
+
+inline void writeU32(uchar *p, quint32 v)
+{
+    p[0] = uchar(v);
+    p[1] = uchar(v >> 8);
+    p[2] = uchar(v >> 16);
+    p[3] = uchar(v >> 24);
+}
+
+inline void writeI16(uchar *p, qint16 v)
+{
+    p[0] = uchar(quint16(v));
+    p[1] = uchar(quint16(v) >> 8);
+}
+
+// 按比例转成定点数并截断到目标类型范围
+inline qint32 toFixed32(double value, double scale)
+{
+    const double v = std::floor(value * scale + 0.5);
+    return qint32(qBound(-2147483648.0, v, 2147483647.0));
+}
+
+inline qint16 toFixed16(double value, double scale)
+{
+    const double v = std::floor(value * scale + 0.5);
+    return qint16(qBound(-32768.0, v, 32767.0));
+}
+
+// 角度归一化到 [-180, 180)，0.01° 精度下才能放进 i16
+inline double wrapDegrees(double degrees)
+{
+    return degrees - 360.0 * std::floor((degrees + 180.0) / 360.0);
+}
+
+} // namespace
+
+namespace TelemetryBinary {
+
+bool decode(const char *data, int length, TelemetrySample &sample,
+            TelemetryParser::Result &result, quint32 *sequence)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    if (length < HeaderSize || p[0] != Magic || p[1] == 0 || p[1] > Version)
+        return false;
+
+    const quint32 sections = p[2];
+    const int idLength = p[3];
+    int expected = HeaderSize + idLength;
+    if (sections & TelemetrySample::GPS)
+        expected += GpsSize;
+    if (sections & TelemetrySample::Gimbal)
+        expected += GimbalSize;
+    if (sections & TelemetrySample::Battery)
+        expected += BatterySize;
+    if (idLength > MaxDroneIdLength || length < expected)
+        return false;
+
+    if (sequence)
+        *sequence = readU32(p + 4);
+    result.sections = sections & (TelemetrySample::GPS | TelemetrySample::Gimbal | TelemetrySample::Battery);
+    result.droneId = idLength ? data + HeaderSize : 0;
+    result.droneIdLength = idLength;
+
+    p += HeaderSize + idLength;
+    if (sections & TelemetrySample::GPS) {
+        sample.longitude = readI32(p) * 1e-7;
+        sample.latitude  = readI32(p + 4) * 1e-7;
+        sample.altitude  = readI32(p + 8) * 1e-3;
+        sample.velocityX = readI16(p + 12) * 1e-2;
+        sample.velocityY = readI16(p + 14) * 1e-2;
+        sample.velocityZ = readI16(p + 16) * 1e-2;
+        sample.yaw       = readI16(p + 18) * 1e-2;
+        p += GpsSize;
+    }
+    if (sections & TelemetrySample::Gimbal) {
+        sample.gimbalPitch = readI16(p) * 1e-2;
+        sample.gimbalRoll  = readI16(p + 2) * 1e-2;
+        sample.gimbalYaw   = readI16(p + 4) * 1e-2;
+        p += GimbalSize;
+    }
+    if (sections & TelemetrySample::Battery)
+        sample.batteryPercent = p[0];
+
+    return true;
+}
+
+int encode(const TelemetrySample &sample, quint32 sections, quint32 sequence,
+           const char *droneId, int droneIdLength, char *out, int capacity)
+{
+    droneIdLength = qBound(0, droneIdLength, int(MaxDroneIdLength));
+    sections &= TelemetrySample::GPS | TelemetrySample::Gimbal | TelemetrySample::Battery;
+
+    int size = HeaderSize + droneIdLength;
+    if (sections & TelemetrySample::GPS)
+        size += GpsSize;
+    if (sections & TelemetrySample::Gimbal)
+        size += GimbalSize;
+    if (sections & TelemetrySample::Battery)
+        size += BatterySize;
+    if (size > capacity)
+        return 0;
+
+    uchar *p = reinterpret_cast<uchar *>(out);
+    p[0] = Magic;
+    p[1] = Version;
+    p[2] = uchar(sections);
+    p[3] = uchar(droneIdLength);
+    writeU32(p + 4, sequence);
+    if (droneIdLength)
+        std::memcpy(p + HeaderSize, droneId, droneIdLength);
+
+    p += HeaderSize + droneIdLength;
+    if (sections & TelemetrySample::GPS) {
+        writeU32(p,     quint32(toFixed32(sample.longitude, 1e7)));
+        writeU32(p + 4, quint32(toFixed32(sample.latitude, 1e7)));
+        writeU32(p + 8, quint32(toFixed32(sample.altitude, 1e3)));
+        writeI16(p + 12, toFixed16(sample.velocityX, 1e2));
+        writeI16(p + 14, toFixed16(sample.velocityY, 1e2));
+        writeI16(p + 16, toFixed16(sample.velocityZ, 1e2));
+        writeI16(p + 18, toFixed16(wrapDegrees(sample.yaw), 1e2));
+        p += GpsSize;
+    }
+    if (sections & TelemetrySample::Gimbal) {
+        writeI16(p,     toFixed16(wrapDegrees(sample.gimbalPitch), 1e2));
+        writeI16(p + 2, toFixed16(wrapDegrees(sample.gimbalRoll), 1e2));
+        writeI16(p + 4, toFixed16(wrapDegrees(sample.gimbalYaw), 1e2));
+        p += GimbalSize;
+    }
+    if (sections & TelemetrySample::Battery)
+        p[0] = uchar(qBound(0.0, std::floor(sample.batteryPercent + 0.5), 255.0));
+
+    return size;
+}
+
+} // namespace TelemetryBinary
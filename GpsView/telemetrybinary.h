@@ -0,0 +1,47 @@
+#ifndef TELEMETRYBINARY_H
+#define TELEMETRYBINARY_H
+
+#include "telemetryparser.h"
+
+// 紧凑二进制遥测格式，与 JSON 共用 2 字节大端长度前缀的分帧方式。
+// 帧内容（小端）：
+//   u8  magic (0xA5)      JSON 报文总以 '{' 开头，据此区分
+//   u8  version
+//   u8  sections          TelemetrySample::Section 按位或
+//   u8  droneIdLength     0..MaxDroneIdLength
+//   u32 sequence          发送端序号
+//   ..  droneId           UTF-8，droneIdLength 字节
+//   GPS     (20 字节) i32 经度 1e-7°, i32 纬度 1e-7°, i32 高度 mm,
+//                     i16 velocityX/Y/Z cm/s, i16 yaw 0.01°
+//   Gimbal  ( 6 字节) i16 pitch/roll/yaw 0.01°
+//   Battery ( 1 字节) u8 剩余电量 %
+// 各部分按上面的顺序出现，只有 sections 中置位的才写入。
+namespace TelemetryBinary {
+
+enum {
+    Magic = 0xA5,
+    Version = 1,
+    HeaderSize = 8,
+    GpsSize = 20,
+    GimbalSize = 6,
+    BatterySize = 1,
+    MaxDroneIdLength = 32,
+    MaxFrameSize = HeaderSize + MaxDroneIdLength + GpsSize + GimbalSize + BatterySize
+};
+
+inline bool isBinaryFrame(const char *data, int length)
+{
+    return length > 0 && quint8(data[0]) == Magic;
+}
+
+// 解码一帧；格式或版本不对时返回 false。result.droneId 指向输入缓冲区
+bool decode(const char *data, int length, TelemetrySample &sample,
+            TelemetryParser::Result &result, quint32 *sequence = 0);
+
+// 参考编码器：编码 sample 中 sections 指定的部分，返回写入字节数，空间不足返回 0
+int encode(const TelemetrySample &sample, quint32 sections, quint32 sequence,
+           const char *droneId, int droneIdLength, char *out, int capacity);
+
+} // namespace TelemetryBinary
+
+#endif // TELEMETRYBINARY_H
@@ -0,0 +1,127 @@
+#include "telemetrychart.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QComboBox>
+#include <QVBoxLayout>
+
+
+TelemetryChart::TelemetryChart(const TimeSeriesStore *store, TimeSeriesStore::Channel channel,
+                               QWidget *parent)
+    : QWidget(parent),
+      series(store),
+      channel(channel),
+      window(0)
+{
+    setMinimumHeight(80);
+}
+
+void TelemetryChart::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(rect().adjusted(4, 2, -4, -2), Qt::AlignTop | Qt::AlignLeft,
+                     TimeSeriesStore::name(channel));
+    if (series->isEmpty())
+        return;
+
+    const qint64 toNs = series->lastTimeNs();
+    const qint64 fromNs = window ? qMax(series->firstTimeNs(), toNs - window) : series->firstTimeNs();
+    const QRectF plot = QRectF(rect()).adjusted(40, 18, -4, -4);
+    if (plot.width() < 2 || plot.height() < 2)
+        return;
+
+    // 每个像素列最多一个桶
+    series->query(channel, fromNs, toNs, int(plot.width()), buckets);
+    if (buckets.isEmpty())
+        return;
+
+    float low = buckets[0].min, high = buckets[0].max;
+    for (int i = 1; i < buckets.size(); ++i) {
+        low = qMin(low, buckets[i].min);
+        high = qMax(high, buckets[i].max);
+    }
+    if (high - low < 1e-3f) {
+        low -= 0.5f;
+        high += 0.5f;
+    }
+
+    const double span = qMax<qint64>(1, toNs - fromNs);
+    auto xAt = [&](qint64 t) { return plot.left() + plot.width() * (t - fromNs) / span; };
+    auto yAt = [&](float v) { return plot.bottom() - plot.height() * (v - low) / (high - low); };
+
+    painter.drawText(QRectF(0, plot.top() - 6, 36, 12), Qt::AlignRight | Qt::AlignVCenter,
+                     QString::number(high, 'f', 1));
+    painter.drawText(QRectF(0, plot.bottom() - 6, 36, 12), Qt::AlignRight | Qt::AlignVCenter,
+                     QString::number(low, 'f', 1));
+
+    // min-max 范围
+    QColor band = palette().color(QPalette::Highlight);
+    band.setAlpha(80);
+    painter.setPen(band);
+    for (int i = 0; i < buckets.size(); ++i) {
+        const TimeSeriesStore::Bucket &b = buckets[i];
+        if (b.max > b.min) {
+            const double x = xAt(b.timeNs);
+            painter.drawLine(QPointF(x, yAt(b.min)), QPointF(x, yAt(b.max)));
+        }
+    }
+
+    // 均值
+    QPainterPath path;
+    path.moveTo(xAt(buckets[0].timeNs), yAt(buckets[0].mean));
+    for (int i = 1; i < buckets.size(); ++i)
+        path.lineTo(xAt(buckets[i].timeNs), yAt(buckets[i].mean));
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(palette().color(QPalette::Highlight), 1.5));
+    painter.drawPath(path);
+}
+
+ChartPanel::ChartPanel(const TimeSeriesStore *store, QWidget *parent)
+    : QWidget(parent)
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+
+    windowSelect = new QComboBox(this);
+    windowSelect->addItem(tr("Last minute"), Q_INT64_C(60000000000));
+    windowSelect->addItem(tr("Last 10 minutes"), Q_INT64_C(600000000000));
+    windowSelect->addItem(tr("Last hour"), Q_INT64_C(3600000000000));
+    windowSelect->addItem(tr("Whole flight"), Q_INT64_C(0));
+    connect(windowSelect, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, &ChartPanel::setWindow);
+    layout->addWidget(windowSelect);
+
+    for (int c = 0; c < TimeSeriesStore::ChannelCount; ++c) {
+        TelemetryChart *chart = new TelemetryChart(store, TimeSeriesStore::Channel(c), this);
+        layout->addWidget(chart, 1);
+        charts.append(chart);
+    }
+    setWindow();
+
+    refreshTimer.setInterval(250);
+    connect(&refreshTimer, &QTimer::timeout, this, [this]() {
+        for (int i = 0; i < charts.size(); ++i)
+            charts[i]->update();
+    });
+}
+
+void ChartPanel::setWindow()
+{
+    const qint64 window = windowSelect->currentData().toLongLong();
+    for (int i = 0; i < charts.size(); ++i)
+        charts[i]->setWindow(window);
+}
+
+void ChartPanel::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refreshTimer.start();
+}
+
+void ChartPanel::hideEvent(QHideEvent *event)
+{
+    refreshTimer.stop();
+    QWidget::hideEvent(event);
+}
@@ -0,0 +1,53 @@
+#ifndef TELEMETRYCHART_H
+#define TELEMETRYCHART_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QVector>
+
+#include "timeseries.h"
+
+class QComboBox;
+
+// 单个通道的曲线：每个桶画一条 min-max 竖线，再用折线连接均值
+class TelemetryChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    TelemetryChart(const TimeSeriesStore *store, TimeSeriesStore::Channel channel, QWidget *parent = 0);
+
+    // 显示最近 windowNs 的数据，0 为整次飞行
+    void setWindow(qint64 windowNs) { window = windowNs; update(); }
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    const TimeSeriesStore *series;
+    TimeSeriesStore::Channel channel;
+    qint64 window;
+    QVector<TimeSeriesStore::Bucket> buckets;      // 复用的查询结果
+};
+
+// 高度、速度、电量四条曲线和时间范围选择；显示时定时刷新，隐藏时不做任何事
+class ChartPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ChartPanel(const TimeSeriesStore *store, QWidget *parent = 0);
+
+protected:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+
+private:
+    void setWindow();
+
+    QComboBox *windowSelect;
+    QVector<TelemetryChart *> charts;
+    QTimer refreshTimer;
+};
+
+#endif // TELEMETRYCHART_H
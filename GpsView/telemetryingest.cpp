@@ -0,0 +1,238 @@
+#include "telemetryingest.h"
+#include "dronesession.h"
+#include "telemetryparser.h"
+#include "telemetrybinary.h"
+#include "flightrecorder.h"
+#include "perfstats.h"
+#include "logging.h"
+#include "trace.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QTimer>
+#include <QHostAddress>
+#include <QDateTime>
+
+
+TelemetryIngest::TelemetryIngest(QObject *parent)
+    : QObject(parent),
+      tcpServer(new QTcpServer(this)),
+      udpSocket(new QUdpSocket(this)),
+      udpExpiryTimer(new QTimer(this)),
+      flightRecorder(0),
+      decoded(0)
+{
+    connect(tcpServer, &QTcpServer::newConnection,
+            this, &TelemetryIngest::acceptConnection);
+    connect(udpSocket, &QUdpSocket::readyRead,
+            this, &TelemetryIngest::readDatagrams);
+
+    udpExpiryTimer->setInterval(UdpSessionTimeout / 4);
+    connect(udpExpiryTimer, &QTimer::timeout, this, &TelemetryIngest::expireUdpSessions);
+}
+
+void TelemetryIngest::listen(const QString &address, int port, int transport)
+{
+    // 重新监听时关掉原来的端口，已建立的 TCP 连接保留
+    tcpServer->close();
+    udpSocket->close();
+
+    if (transport == Udp) {
+        if (!udpSocket->bind(QHostAddress(address), port)) {
+            qCWarning(lcIngest) << udpSocket->errorString();
+            emit listenFailed(udpSocket->errorString());
+        }
+        return;
+    }
+
+    if (!tcpServer->listen(QHostAddress(address), port)) {
+        qCWarning(lcIngest) << tcpServer->errorString();
+        emit listenFailed(tcpServer->errorString());
+    }
+}
+
+void TelemetryIngest::setActiveDrone(const QString &id)
+{
+    activeId = id;
+
+    // 切换飞机后立即把它最近的状态送到界面
+    DroneSession *session = sessions.value(id);
+    if (session)
+        publish(session, QString());
+}
+
+void TelemetryIngest::acceptConnection()
+{
+    // 每架飞机一个会话，重连或新飞机都不会覆盖已有连接
+    while (tcpServer->hasPendingConnections()) {
+        DroneSession *session = new DroneSession(tcpServer->nextPendingConnection(), this);
+        connect(session, &DroneSession::frameReceived, this, &TelemetryIngest::handleFrame);
+        connect(session, &DroneSession::disconnected, this, &TelemetryIngest::removeSession);
+
+        sessions.insert(session->id(), session);
+    }
+    updateSessions();
+}
+
+void TelemetryIngest::readDatagrams()
+{
+    Trace::Span span("socket read");
+    QHostAddress address;
+    quint16 port;
+    const qint64 nowNs = Telemetry::monotonicNs();
+    while (udpSocket->hasPendingDatagrams()) {
+        datagram.resize(int(udpSocket->pendingDatagramSize()));
+        const qint64 size = udpSocket->readDatagram(datagram.data(), datagram.size(), &address, &port);
+        if (size < 4)
+            continue;
+        Perf::add(Perf::BytesReceived, quint64(size));
+
+        DroneSession *&session = udpPeers[qMakePair(address, port)];
+        if (!session) {
+            session = new DroneSession(QString("%1:%2").arg(address.toString()).arg(port), this);
+            sessions.insert(session->id(), session);
+            updateSessions();
+            if (!udpExpiryTimer->isActive())
+                udpExpiryTimer->start();
+        }
+
+        const uchar *p = reinterpret_cast<const uchar *>(datagram.constData());
+        const quint32 sequence = quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24;
+        if (!session->acceptSequence(sequence, nowNs))
+            continue;
+
+        handleFrame(session, QByteArray::fromRawData(datagram.constData() + 4, int(size) - 4));
+    }
+}
+
+// UDP 没有断开通知，发送端走了以后会话一直留着，按最后收到新包的时间清理
+void TelemetryIngest::expireUdpSessions()
+{
+    const qint64 deadline = Telemetry::monotonicNs() - qint64(UdpSessionTimeout) * 1000000;
+    const QList<DroneSession *> peers = udpPeers.values();
+    for (DroneSession *session : peers) {
+        if (session->lastAcceptedNs() < deadline)
+            removeSession(session);
+    }
+    if (udpPeers.isEmpty())
+        udpExpiryTimer->stop();
+}
+
+// 收到 DroneID 后以其为键；同一 ID 的旧连接视为已断开的重连，直接丢弃
+void TelemetryIngest::renameSession(DroneSession *session, const QString &id)
+{
+    DroneSession *stale = sessions.value(id);
+    if (stale)
+        removeSession(stale);
+
+    if (activeId == session->id())
+        activeId = id;
+    sessions.remove(session->id());
+    session->setId(id);
+    sessions.insert(id, session);
+    updateSessions();
+}
+
+void TelemetryIngest::removeSession(DroneSession *session)
+{
+    if (sessions.value(session->id()) == session)
+        sessions.remove(session->id());
+    if (!session->socket())
+        udpPeers.remove(udpPeers.key(session));
+
+    session->abort();
+    session->deleteLater();
+    updateSessions();
+}
+
+void TelemetryIngest::updateSessions()
+{
+    // 当前飞机断开后自动切到另一架
+    if (!sessions.contains(activeId) && !sessions.isEmpty())
+        setActiveDrone(sessions.begin().key());
+
+    emit sessionsChanged(sessions.keys(), activeId);
+}
+
+void TelemetryIngest::handleFrame(DroneSession *session, const QByteArray &frame)
+{
+    Trace::Span span("decode frame");
+    qCDebug(lcIngest) << "frame len:" << frame.size() << "[" << frame << "]";
+
+    if (session->protocol() == DroneSession::UnknownProtocol) {
+        session->setProtocol(TelemetryBinary::isBinaryFrame(frame.constData(), frame.size())
+                             ? DroneSession::BinaryProtocol : DroneSession::JsonProtocol);
+    }
+    const bool binary = session->protocol() == DroneSession::BinaryProtocol;
+
+    // 解析到临时副本中，报文损坏时不污染该飞机的状态
+    TelemetrySample sample = session->sample;
+    sample.sentMs = 0;
+    TelemetryParser::Result result;
+    const qint64 parseStart = Telemetry::monotonicNs();
+    const bool ok = binary
+            ? TelemetryBinary::decode(frame.constData(), frame.size(), sample, result)
+            : TelemetryParser::parse(frame.constData(), frame.size(), sample, result);
+    const qint64 parsedNs = Telemetry::monotonicNs();
+    Perf::record(Perf::ParseTime, parsedNs - parseStart);
+    if (Trace::isEnabled())
+        Trace::record(binary ? "parse binary" : "parse json", parseStart, parsedNs, sample.sequence + 1);
+    if (!ok) {
+        Perf::add(Perf::ParseErrors);
+        qCDebug(lcIngest) << "===> please check the string " << frame;
+        return;
+    }
+    Perf::add(Perf::FramesDecoded);
+    if (sample.sentMs > 0)
+        Perf::record(Perf::LinkDelay, qMax<qint64>(0, QDateTime::currentMSecsSinceEpoch() - qint64(sample.sentMs)) * 1000000);
+
+    if (result.droneId && session->id() != QLatin1String(result.droneId, result.droneIdLength)) {
+        const QString id = QString::fromUtf8(result.droneId, result.droneIdLength);
+        if (id != session->id())
+            renameSession(session, id);
+    }
+
+    sample.sections |= result.sections;
+    sample.sequence++;
+    span.setId(sample.sequence);
+    sample.timestampNs = parsedNs;
+    session->sample = sample;
+    decoded.storeRelease(decoded.load() + 1);
+
+    // 所有飞机的报文都记录，不只是当前显示的
+    if (flightRecorder)
+        flightRecorder->record(sample, sample.timestampNs, session->idUtf8());
+
+    // 只有当前选中的飞机才送往界面，也只有它需要生成日志文本
+    if (session->id() != activeId)
+        return;
+    if (binary) {
+        publish(session, QString("[binary %1 B] lng %2 lat %3 alt %4 bat %5%")
+                .arg(frame.size())
+                .arg(sample.longitude, 0, 'f', 7).arg(sample.latitude, 0, 'f', 7)
+                .arg(sample.altitude, 0, 'f', 1).arg(sample.batteryPercent));
+    } else {
+        publish(session, QString::fromUtf8(frame));
+    }
+}
+
+void TelemetryIngest::publish(DroneSession *session, const QString &message)
+{
+    TelemetrySnapshot snapshot;
+    snapshot.sample = session->sample;
+    snapshot.link = session->linkStats();
+    snapshot.message = message;
+    snapshot.receivedMs = QDateTime::currentMSecsSinceEpoch();
+
+    // 界面线程处理不过来时丢弃最新数据，接收线程不等待
+    if (!snapshots.push(snapshot)) {
+        Perf::add(Perf::SnapshotsDropped);
+        return;
+    }
+    Perf::record(Perf::QueueDepth, snapshots.size());
+
+    // 界面取走数据之前只通知一次，避免每条报文一个跨线程事件
+    if (notifyPending.testAndSetOrdered(0, 1))
+        emit snapshotsReady();
+}
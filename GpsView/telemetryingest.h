@@ -0,0 +1,88 @@
+#ifndef TELEMETRYINGEST_H
+#define TELEMETRYINGEST_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QAtomicInt>
+#include <QHostAddress>
+#include <QPair>
+
+#include "spscqueue.h"
+#include "telemetrysample.h"
+#include "dronesession.h"
+
+class QTcpServer;
+class QUdpSocket;
+class QTimer;
+class DroneSession;
+class FlightRecorder;
+
+// 交给界面线程的一次遥测更新
+struct TelemetrySnapshot
+{
+    TelemetrySample sample;
+    LinkStats link;
+    QString message;       // 解码后的原始报文，用于日志显示
+    qint64 receivedMs;     // 接收时间（ms since epoch）
+};
+
+// 遥测接收：运行在独立的网络线程中，负责监听、拆帧、UTF-8 解码和 JSON 解析，
+// 结果经无锁队列交给界面线程，界面卡顿不会拖慢接收。
+//
+// UDP 模式下每个数据包是一条完整报文：u32 小端序号 + JSON 或二进制报文（不带长度前缀）。
+// 只使用比已收到的都新的包，迟到和重复的包丢弃并计数。
+// UDP 会话在 UdpSessionTimeout 内没有新包时移除。
+class TelemetryIngest : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Transport { Tcp, Udp };
+    enum { UdpSessionTimeout = 30000 };        // ms
+
+    explicit TelemetryIngest(QObject *parent = 0);
+
+    // 在网络线程启动之前设置；之后每条解码成功的报文都交给它记录
+    void setRecorder(FlightRecorder *recorder) { flightRecorder = recorder; }
+
+    // 以下两个函数只能在界面线程调用
+    void rearmNotify() { notifyPending.storeRelease(0); }
+    bool takeSnapshot(TelemetrySnapshot &snapshot) { return snapshots.pop(snapshot); }
+    // 所有飞机累计解析成功的报文数，任意线程可读
+    quint64 decodedFrames() const { return decoded.loadAcquire(); }
+
+public slots:
+    void listen(const QString &address, int port, int transport);
+    void setActiveDrone(const QString &id);
+
+signals:
+    void snapshotsReady();                      // 界面 rearmNotify() 之前只发出一次
+    void sessionsChanged(const QStringList &ids, const QString &activeId);
+    void listenFailed(const QString &error);
+
+private:
+    void acceptConnection();
+    void readDatagrams();
+    void expireUdpSessions();
+    void handleFrame(DroneSession *session, const QByteArray &frame);
+    void renameSession(DroneSession *session, const QString &id);
+    void removeSession(DroneSession *session);
+    void updateSessions();
+    void publish(DroneSession *session, const QString &message);
+
+    QTcpServer *tcpServer;
+    QUdpSocket *udpSocket;
+    QByteArray datagram;                       // 复用的 UDP 接收缓冲区
+    QTimer *udpExpiryTimer;
+    QHash<QString, DroneSession *> sessions;   // 按飞机 ID 索引的连接
+    QHash<QPair<QHostAddress, quint16>, DroneSession *> udpPeers;
+    QString activeId;                          // 界面上显示的飞机
+    FlightRecorder *flightRecorder;
+
+    SpscQueue<TelemetrySnapshot, 1024> snapshots;
+    QAtomicInt notifyPending;
+    QAtomicInteger<quint64> decoded;           // 只有网络线程写
+};
+
+#endif // TELEMETRYINGEST_H
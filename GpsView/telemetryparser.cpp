@@ -0,0 +1,280 @@
+#include "telemetryparser.h"
+
+#include <cmath>
+#include <cstring>
+
+
+namespace {
+
+enum Section { NoSection, GpsSection, GimbalSection, BatterySection };
+
+class Scanner
+{
+public:
+    Scanner(const char *data, int length)
+        : p(data), end(data + length) {}
+
+    const char *p;
+    const char *end;
+
+    void skipSpace()
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+            ++p;
+    }
+
+    bool consume(char c)
+    {
+        skipSpace();
+        if (p < end && *p == c) {
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    char peek()
+    {
+        skipSpace();
+        return p < end ? *p : 0;
+    }
+
+    // 读取字符串，返回引号内的原始字节（不处理转义）
+    bool string(const char *&begin, int &length)
+    {
+        if (!consume('"'))
+            return false;
+        begin = p;
+        while (p < end && *p != '"') {
+            if (*p == '\\')
+                ++p;
+            ++p;
+        }
+        if (p >= end)
+            return false;
+        length = int(p - begin);
+        ++p;
+        return true;
+    }
+
+    bool number(double &value)
+    {
+        skipSpace();
+        bool negative = false;
+        if (p < end && *p == '-') {
+            negative = true;
+            ++p;
+        }
+
+        quint64 mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        const char *start = p;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + quint64(*p - '0');
+                if (mantissa)
+                    ++digits;
+            } else {
+                ++exponent;
+            }
+        }
+        if (p < end && *p == '.') {
+            for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + quint64(*p - '0');
+                    if (mantissa)
+                        ++digits;
+                    --exponent;
+                }
+            }
+        }
+        if (p == start || (p - start == 1 && *start == '.'))
+            return false;
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            bool negativeExp = false;
+            if (p < end && (*p == '+' || *p == '-'))
+                negativeExp = (*p++ == '-');
+            int e = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; ++p)
+                e = qMin(e * 10 + (*p - '0'), 1000);
+            exponent += negativeExp ? -e : e;
+        }
+
+        // 尾数不超过 2^53 且指数在 ±22 以内时一次乘除即可精确舍入，
+        // 经纬度、速度等遥测数值都落在这个范围
+        static const double pow10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        double v = double(mantissa);
+        if (mantissa < (quint64(1) << 53) && exponent >= -22 && exponent <= 22)
+            v = exponent < 0 ? v / pow10[-exponent] : v * pow10[exponent];
+        else
+            v = v * std::pow(10.0, exponent);
+
+        value = negative ? -v : v;
+        return true;
+    }
+
+    bool literal(const char *word, int length)
+    {
+        if (end - p < length || std::memcmp(p, word, length) != 0)
+            return false;
+        p += length;
+        return true;
+    }
+
+    bool skipValue(int depth = 0)
+    {
+        if (depth > 64)
+            return false;
+
+        const char *begin;
+        int length;
+        double number;
+        switch (peek()) {
+        case '"':
+            return string(begin, length);
+        case '{':
+            ++p;
+            if (consume('}'))
+                return true;
+            do {
+                if (!string(begin, length) || !consume(':') || !skipValue(depth + 1))
+                    return false;
+            } while (consume(','));
+            return consume('}');
+        case '[':
+            ++p;
+            if (consume(']'))
+                return true;
+            do {
+                if (!skipValue(depth + 1))
+                    return false;
+            } while (consume(','));
+            return consume(']');
+        case 't':
+            return literal("true", 4);
+        case 'f':
+            return literal("false", 5);
+        case 'n':
+            return literal("null", 4);
+        default:
+            return this->number(number);
+        }
+    }
+};
+
+inline bool keyIs(const char *key, int length, const char *name)
+{
+    return int(std::strlen(name)) == length && std::memcmp(key, name, length) == 0;
+}
+
+Section sectionFor(const char *key, int length)
+{
+    if (keyIs(key, length, "GPS"))
+        return GpsSection;
+    if (keyIs(key, length, "Gimbal"))
+        return GimbalSection;
+    if (keyIs(key, length, "Battery"))
+        return BatterySection;
+    return NoSection;
+}
+
+double *fieldFor(Section section, const char *key, int length, TelemetrySample &sample)
+{
+    switch (section) {
+    case GpsSection:
+        if (keyIs(key, length, "longitude"))  return &sample.longitude;
+        if (keyIs(key, length, "latitude"))   return &sample.latitude;
+        if (keyIs(key, length, "altitude"))   return &sample.altitude;
+        if (keyIs(key, length, "velocityX"))  return &sample.velocityX;
+        if (keyIs(key, length, "velocityY"))  return &sample.velocityY;
+        if (keyIs(key, length, "velocityZ"))  return &sample.velocityZ;
+        if (keyIs(key, length, "yaw"))        return &sample.yaw;
+        if (keyIs(key, length, "timestamp"))  return &sample.sentMs;
+        break;
+    case GimbalSection:
+        if (keyIs(key, length, "pitch"))      return &sample.gimbalPitch;
+        if (keyIs(key, length, "roll"))       return &sample.gimbalRoll;
+        if (keyIs(key, length, "yaw"))        return &sample.gimbalYaw;
+        break;
+    case BatterySection:
+        if (keyIs(key, length, "BatteryEnergyRemainingPercent"))
+            return &sample.batteryPercent;
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+bool parseSection(Scanner &in, Section section, TelemetrySample &sample)
+{
+    if (!in.consume('{'))
+        return false;
+    if (in.consume('}'))
+        return true;
+
+    const char *key;
+    int length;
+    do {
+        if (!in.string(key, length) || !in.consume(':'))
+            return false;
+
+        double *field = fieldFor(section, key, length, sample);
+        const char c = in.peek();
+        if (field && (c == '-' || (c >= '0' && c <= '9'))) {
+            if (!in.number(*field))
+                return false;
+        } else {
+            // 与 QJsonValue::toDouble() 一致：非数值按 0 处理
+            if (field)
+                *field = 0;
+            if (!in.skipValue())
+                return false;
+        }
+    } while (in.consume(','));
+
+    return in.consume('}');
+}
+
+} // namespace
+
+bool TelemetryParser::parse(const char *data, int length, TelemetrySample &sample, Result &result)
+{
+    result.sections = 0;
+    result.droneId = 0;
+    result.droneIdLength = 0;
+
+    Scanner in(data, length);
+    if (!in.consume('{'))
+        return false;
+    if (in.consume('}'))
+        return true;
+
+    const char *key;
+    int keyLength;
+    do {
+        if (!in.string(key, keyLength) || !in.consume(':'))
+            return false;
+
+        const Section section = sectionFor(key, keyLength);
+        if (section != NoSection && in.peek() == '{') {
+            if (!parseSection(in, section, sample))
+                return false;
+            result.sections |= section == GpsSection    ? TelemetrySample::GPS
+                             : section == GimbalSection ? TelemetrySample::Gimbal
+                                                        : TelemetrySample::Battery;
+        } else if (keyIs(key, keyLength, "DroneID") && in.peek() == '"') {
+            if (!in.string(result.droneId, result.droneIdLength))
+                return false;
+        } else if (!in.skipValue()) {
+            return false;
+        }
+    } while (in.consume(','));
+
+    return in.consume('}');
+}
@@ -0,0 +1,23 @@
+#ifndef TELEMETRYPARSER_H
+#define TELEMETRYPARSER_H
+
+#include "telemetrysample.h"
+
+// 针对 {"DroneID":..,"GPS":{..},"Gimbal":{..},"Battery":{..}} 报文的流式解析器。
+// 直接扫描 UTF-8 字节，只把已知字段写进 TelemetrySample，不建 DOM、不分配内存；
+// 未知字段按 JSON 语法跳过。
+class TelemetryParser
+{
+public:
+    struct Result
+    {
+        quint32 sections;       // 本条报文包含的部分（TelemetrySample::Section）
+        const char *droneId;    // 指向输入缓冲区，未转义；没有 DroneID 时为 0
+        int droneIdLength;
+    };
+
+    // 解析失败（不是合法的 JSON 对象）时返回 false，sample 中可能已写入部分字段
+    static bool parse(const char *data, int length, TelemetrySample &sample, Result &result);
+};
+
+#endif // TELEMETRYPARSER_H
@@ -0,0 +1,61 @@
+#ifndef TELEMETRYSAMPLE_H
+#define TELEMETRYSAMPLE_H
+
+#include <QtGlobal>
+#include <chrono>
+
+// 一架飞机某一时刻的完整遥测状态。纯数据结构，按值拷贝，不涉及堆分配。
+struct TelemetrySample
+{
+    enum Section {
+        GPS     = 0x1,
+        Gimbal  = 0x2,
+        Battery = 0x4
+    };
+
+    quint64 sequence;       // 该飞机的报文序号，从 1 开始
+    qint64  timestampNs;    // 接收时刻，monotonicNs() 时钟
+    quint32 sections;       // 已收到过的部分（Section 按位或）
+
+    // GPS
+    double longitude;
+    double latitude;
+    double altitude;
+    double velocityX;       // m/s，DJI MSDK 的 NED：北
+    double velocityY;       // 东
+    double velocityZ;       // 向下为正
+    double yaw;
+    double sentMs;          // 发送端时刻（Unix ms，可选），只对本帧有效，没有时为 0
+
+    // Gimbal
+    double gimbalPitch;
+    double gimbalRoll;
+    double gimbalYaw;
+
+    // Battery
+    double batteryPercent;  // BatteryEnergyRemainingPercent
+};
+
+Q_DECLARE_TYPEINFO(TelemetrySample, Q_PRIMITIVE_TYPE);
+
+namespace Telemetry {
+
+// 所有模块共用的单调时钟（ns），遥测、视频等时间戳都以它为准
+inline qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 报文带发送时刻时的链路延迟（ns）：收到时的 Unix 时间 - 发送时刻，没有发送时刻时为 0。
+// nowNs 与 wallMs 为同一时刻的 monotonicNs() 和 Unix ms；两端时钟不同步时可能为负
+inline qint64 linkDelayNs(const TelemetrySample &sample, qint64 nowNs, qint64 wallMs)
+{
+    if (!(sample.sentMs > 0))
+        return 0;
+    return wallMs * 1000000 - (nowNs - sample.timestampNs) - qint64(sample.sentMs) * 1000000;
+}
+
+} // namespace Telemetry
+
+#endif // TELEMETRYSAMPLE_H
@@ -0,0 +1,157 @@
+#include "timeseries.h"
+
+#include <QtNumeric>
+#include <algorithm>
+#include <cmath>
+
+
+TimeSeriesStore::TimeSeriesStore()
+{
+    const qint64 widths[TierCount] = {
+        Q_INT64_C(1000000000), Q_INT64_C(10000000000), Q_INT64_C(60000000000)
+    };
+    for (int i = 0; i < TierCount; ++i)
+        tiers[i].widthNs = widths[i];
+
+    rawTime.resize(RawCapacity);
+    for (int c = 0; c < ChannelCount; ++c)
+        raw[c].resize(RawCapacity);
+    clear();
+}
+
+void TimeSeriesStore::clear()
+{
+    rawHead = 0;
+    rawCount = 0;
+    firstNs = lastNs = -1;
+    for (int i = 0; i < TierCount; ++i) {
+        Tier &tier = tiers[i];
+        tier.start.clear();
+        for (int c = 0; c < ChannelCount; ++c) {
+            tier.min[c].clear();
+            tier.max[c].clear();
+            tier.sum[c].clear();
+            tier.count[c].clear();
+        }
+    }
+}
+
+void TimeSeriesStore::append(const TelemetrySample &sample)
+{
+    // 时间倒退的样本（如切换到回放）直接丢弃，调用方应先 clear()
+    const qint64 t = sample.timestampNs;
+    if (t < lastNs)
+        return;
+
+    const bool gps = sample.sections & TelemetrySample::GPS;
+    const bool battery = sample.sections & TelemetrySample::Battery;
+    const float values[ChannelCount] = {
+        float(sample.altitude),
+        float(std::sqrt(sample.velocityX * sample.velocityX + sample.velocityY * sample.velocityY)),
+        float(sample.velocityZ),
+        float(sample.batteryPercent)
+    };
+    const bool present[ChannelCount] = { gps, gps, gps, battery };
+    if (!gps && !battery)
+        return;
+
+    rawTime[rawHead] = t;
+    for (int c = 0; c < ChannelCount; ++c)
+        raw[c][rawHead] = present[c] ? values[c] : float(qQNaN());
+    rawHead = (rawHead + 1) % RawCapacity;
+    rawCount = qMin(rawCount + 1, int(RawCapacity));
+
+    for (int i = 0; i < TierCount; ++i)
+        appendToTier(tiers[i], t, values, present);
+
+    if (firstNs < 0)
+        firstNs = t;
+    lastNs = t;
+}
+
+void TimeSeriesStore::appendToTier(Tier &tier, qint64 timeNs, const float *values, const bool *present)
+{
+    const qint64 start = timeNs - timeNs % tier.widthNs;
+    if (tier.start.isEmpty() || tier.start.last() != start) {
+        tier.start.append(start);
+        for (int c = 0; c < ChannelCount; ++c) {
+            tier.min[c].append(values[c]);
+            tier.max[c].append(values[c]);
+            tier.sum[c].append(0);
+            tier.count[c].append(0);
+        }
+    }
+
+    const int last = tier.start.size() - 1;
+    for (int c = 0; c < ChannelCount; ++c) {
+        if (!present[c])
+            continue;
+        if (tier.count[c][last] == 0) {
+            tier.min[c][last] = tier.max[c][last] = values[c];
+        } else {
+            tier.min[c][last] = qMin(tier.min[c][last], values[c]);
+            tier.max[c][last] = qMax(tier.max[c][last], values[c]);
+        }
+        tier.sum[c][last] += values[c];
+        tier.count[c][last]++;
+    }
+}
+
+qint64 TimeSeriesStore::query(Channel channel, qint64 fromNs, qint64 toNs, int maxPoints,
+                              QVector<Bucket> &out) const
+{
+    out.clear();
+    if (isEmpty() || toNs < fromNs)
+        return 0;
+
+    // 原始样本能覆盖整个时间段且点数不多时直接用原始样本
+    const int oldest = (rawHead - rawCount + RawCapacity) % RawCapacity;
+    if (rawCount && rawTime[oldest] <= fromNs) {
+        int n = 0;
+        for (int i = rawCount - 1; i >= 0 && rawTime[(oldest + i) % RawCapacity] >= fromNs; --i)
+            ++n;
+        if (n <= maxPoints) {
+            for (int i = rawCount - n; i < rawCount; ++i) {
+                const int k = (oldest + i) % RawCapacity;
+                const float v = raw[channel][k];
+                if (rawTime[k] > toNs)
+                    break;
+                if (qIsNaN(v))
+                    continue;
+                Bucket b = { rawTime[k], v, v, v };
+                out.append(b);
+            }
+            return 0;
+        }
+    }
+
+    // 选桶数不超过 maxPoints 的最细一层，都超过时用最粗一层
+    int level = TierCount - 1;
+    for (int i = 0; i < TierCount; ++i) {
+        if ((toNs - fromNs) / tiers[i].widthNs + 1 <= maxPoints) {
+            level = i;
+            break;
+        }
+    }
+
+    const Tier &tier = tiers[level];
+    int i = int(std::lower_bound(tier.start.begin(), tier.start.end(), fromNs - tier.widthNs + 1)
+                - tier.start.begin());
+    for (; i < tier.start.size() && tier.start[i] <= toNs; ++i) {
+        const quint32 n = tier.count[channel][i];
+        if (!n)
+            continue;
+        Bucket b = { tier.start[i], tier.min[channel][i], tier.max[channel][i],
+                     float(tier.sum[channel][i] / n) };
+        out.append(b);
+    }
+    return tier.widthNs;
+}
+
+const char *TimeSeriesStore::name(Channel channel)
+{
+    static const char *const names[ChannelCount] = {
+        "Altitude (m)", "Horizontal speed (m/s)", "Vertical speed (m/s)", "Battery (%)"
+    };
+    return names[channel];
+}
@@ -0,0 +1,72 @@
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <QVector>
+
+#include "telemetrysample.h"
+
+// 遥测时间序列：按列保存高度、水平速度、垂直速度和电量。
+// 原始样本只保留最近 RawCapacity 个（环形）；另外按 1 s / 10 s / 1 min
+// 维护 min/max/mean 降采样层，插入时增量更新，整次飞行都保留。
+// 查询时选用能在 maxPoints 以内覆盖所需时间段的最细一层，
+// 三小时的图表只需要几千个桶而不是几百万个原始点。
+class TimeSeriesStore
+{
+public:
+    enum Channel {
+        Altitude,
+        HorizontalSpeed,
+        VerticalSpeed,
+        Battery,
+        ChannelCount
+    };
+
+    enum { RawCapacity = 65536, TierCount = 3 };
+
+    struct Bucket
+    {
+        qint64 timeNs;         // 桶的起始时刻，原始样本为样本时刻
+        float min;
+        float max;
+        float mean;
+    };
+
+    TimeSeriesStore();
+
+    void append(const TelemetrySample &sample);
+    void clear();
+
+    bool isEmpty() const { return lastNs < 0; }
+    qint64 firstTimeNs() const { return firstNs; }
+    qint64 lastTimeNs() const { return lastNs; }
+
+    // [fromNs, toNs] 内的数据，按时间顺序写入 out；返回所用的桶宽（原始样本为 0）
+    qint64 query(Channel channel, qint64 fromNs, qint64 toNs, int maxPoints, QVector<Bucket> &out) const;
+
+    static const char *name(Channel channel);
+
+private:
+    struct Tier
+    {
+        qint64 widthNs;
+        QVector<qint64> start;
+        QVector<float> min[ChannelCount];
+        QVector<float> max[ChannelCount];
+        QVector<double> sum[ChannelCount];
+        QVector<quint32> count[ChannelCount];
+    };
+
+    void appendToTier(Tier &tier, qint64 timeNs, const float *values, const bool *present);
+
+    // 原始样本环形缓冲区，每个通道一列
+    QVector<qint64> rawTime;
+    QVector<float> raw[ChannelCount];
+    int rawHead;           // 下一个写入位置
+    int rawCount;
+
+    Tier tiers[TierCount];
+    qint64 firstNs;
+    qint64 lastNs;
+};
+
+#endif // TIMESERIES_H
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+# 把 GpsView 关键帧目录中的 priors.txt 写入 COLMAP 数据库，供 spatial_matcher 按 GPS 位置配对。
+#
+#   colmap feature_extractor --database_path db.db --image_path keyframes-xxx/images
+#   python3 colmap_import_priors.py db.db keyframes-xxx/priors.txt
+#   colmap spatial_matcher --database_path db.db --SpatialMatching.is_gps 1
+#
+# COLMAP 3.9 起先验在 pose_priors 表中（position 为 3 个 double，坐标系 0 为 WGS-84），
+# 之前的版本在 images 表的 prior_tx/ty/tz 中；两种都支持。位置顺序均为纬度、经度、高度。
+# 高度是相对起飞点的高度而不是椭球高，整批有同一个偏移，对按距离配对影响很小；
+# 需要绝对高度时可加 --SpatialMatching.ignore_z 1 只按水平距离配对。
+
+import sqlite3
+import struct
+import sys
+
+WGS84 = 0
+
+
+def read_priors(path):
+    priors = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if not fields or fields[0].startswith("#"):
+                continue
+            priors[fields[0]] = tuple(float(v) for v in fields[1:4])
+    return priors
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: colmap_import_priors.py DATABASE PRIORS")
+
+    priors = read_priors(sys.argv[2])
+    db = sqlite3.connect(sys.argv[1])
+    tables = {row[0] for row in db.execute("SELECT name FROM sqlite_master WHERE type='table'")}
+    columns = {row[1] for row in db.execute("PRAGMA table_info(images)")}
+    # 早期带 pose_priors 的版本可能还没有 position_covariance 列
+    prior_columns = {row[1] for row in db.execute("PRAGMA table_info(pose_priors)")}
+
+    updated = 0
+    for image_id, name in db.execute("SELECT image_id, name FROM images").fetchall():
+        position = priors.get(name)
+        if position is None:
+            continue
+        if "pose_priors" in tables:
+            row = {"image_id": image_id, "position": struct.pack("<3d", *position),
+                   "coordinate_system": WGS84}
+            if "position_covariance" in prior_columns:
+                row["position_covariance"] = struct.pack("<9d", *([float("nan")] * 9))
+            db.execute("INSERT OR REPLACE INTO pose_priors (%s) VALUES (%s)"
+                       % (", ".join(row), ", ".join("?" * len(row))), list(row.values()))
+        elif "prior_tx" in columns:
+            db.execute("UPDATE images SET prior_tx=?, prior_ty=?, prior_tz=? WHERE image_id=?",
+                       position + (image_id,))
+        else:
+            sys.exit("unknown COLMAP database schema")
+        updated += 1
+
+    db.commit()
+    print("%d of %d priors imported" % (updated, len(priors)))
+
+
+if __name__ == "__main__":
+    main()
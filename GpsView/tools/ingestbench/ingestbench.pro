@@ -0,0 +1,32 @@
+# 遥测接收基准：在同一进程中用回环连接压测 TelemetryIngest，统计吞吐、延迟和内存分配
+QT += core network
+QT -= gui
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = ingestbench
+TEMPLATE = app
+
+INCLUDEPATH += ../.. ../telemetrysender
+
+SOURCES += main.cpp \
+    ../../telemetryingest.cpp \
+    ../../dronesession.cpp \
+    ../../telemetryparser.cpp \
+    ../../telemetrybinary.cpp \
+    ../../flightrecorder.cpp \
+    ../../perfstats.cpp \
+    ../../logging.cpp \
+    ../../trace.cpp
+
+HEADERS += ../../telemetryingest.h \
+    ../../dronesession.h \
+    ../../telemetryparser.h \
+    ../../telemetrybinary.h \
+    ../../telemetrysample.h \
+    ../../flightrecorder.h \
+    ../../perfstats.h \
+    ../../logging.h \
+    ../../trace.h \
+    ../../spscqueue.h \
+    ../telemetrysender/telemetrygen.h
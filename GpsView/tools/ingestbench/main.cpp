@@ -0,0 +1,214 @@
+#include "telemetryingest.h"
+#include "telemetrygen.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+// 按线程统计内存分配：只有打了标记的线程计数。
+// QByteArray、QString、QVector 经 QArrayData 直接调用 malloc/realloc，不经过 operator new，
+// 所以在 glibc 上替换 malloc 系列（libstdc++ 的 operator new 也走 malloc），其它平台不统计
+enum TrackedThread { Untracked, IngestThread, UiThread };
+static thread_local TrackedThread trackedThread = Untracked;
+static std::atomic<quint64> allocations[3];
+
+#if defined(__GLIBC__)
+#define COUNT_ALLOCATIONS 1
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void __libc_free(void *p);
+
+void *malloc(size_t size)
+{
+    allocations[trackedThread].fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    allocations[trackedThread].fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    allocations[trackedThread].fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void free(void *p)
+{
+    __libc_free(p);
+}
+}
+#else
+#define COUNT_ALLOCATIONS 0
+#endif
+
+// 发送端：在自己的线程中开若干个回环连接，尽量快或按指定速率发送
+class LoadGenerator : public QObject
+{
+public:
+    LoadGenerator(int connections, double rate, bool binary)
+        : connections(connections), rate(rate), binary(binary), timer(this) {}
+
+    void start(quint16 port)
+    {
+        for (int i = 0; i < connections; ++i) {
+            QTcpSocket *socket = new QTcpSocket(this);
+            socket->connectToHost(QHostAddress::LocalHost, port);
+            sockets.append(socket);
+            ids.append("BENCH-" + QByteArray::number(i + 1));
+            sequences.append(0);
+        }
+        timer.setTimerType(Qt::PreciseTimer);
+        connect(&timer, &QTimer::timeout, this, &LoadGenerator::send);
+        clock.start();
+        timer.start(1);
+    }
+
+private:
+    void send()
+    {
+        const double elapsed = clock.nsecsElapsed() / 1e9;
+        for (int i = 0; i < sockets.size(); ++i) {
+            QTcpSocket *socket = sockets[i];
+            if (socket->state() != QAbstractSocket::ConnectedState)
+                continue;
+            const quint32 due = rate > 0 ? quint32(elapsed * rate) + 1 : sequences[i] + 1000;
+            while (sequences[i] < due && socket->bytesToWrite() < 256 * 1024) {
+                const TelemetrySample s = simulate(sequences[i], 50.0);
+                socket->write(frame(binary ? encodeBinary(s, ids[i], sequences[i]) : encodeJson(s, ids[i])));
+                ++sequences[i];
+            }
+        }
+    }
+
+    int connections;
+    double rate;
+    bool binary;
+    QTimer timer;
+    QElapsedTimer clock;
+    QVector<QTcpSocket *> sockets;
+    QVector<QByteArray> ids;
+    QVector<quint32> sequences;
+};
+
+static double percentile(QVector<qint64> &values, double p)
+{
+    if (values.isEmpty())
+        return 0;
+    const int k = qMin(values.size() - 1, int(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k] / 1000.0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measure the GpsView telemetry ingest path without a GUI.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("connections", "Simulated aircraft.", "n", "4"));
+    parser.addOption(QCommandLineOption("rate", "Messages per second per connection (0 = as fast as possible).", "hz", "0"));
+    parser.addOption(QCommandLineOption("seconds", "Measurement time after a 1 s warm-up.", "s", "5"));
+    parser.addOption(QCommandLineOption("port", "Loopback port to listen on.", "port", "16666"));
+    parser.addOption(QCommandLineOption("binary", "Send the compact binary format instead of JSON."));
+    parser.process(app);
+
+    const int connections = qMax(1, parser.value("connections").toInt());
+    const double rate = qMax(0.0, parser.value("rate").toDouble());
+    const int seconds = qMax(1, parser.value("seconds").toInt());
+    const quint16 port = quint16(parser.value("port").toUInt());
+
+    // 与 Server 相同：接收在独立线程，本线程相当于界面线程
+    trackedThread = UiThread;
+    QThread ingestThread;
+    TelemetryIngest *ingest = new TelemetryIngest;
+    ingest->moveToThread(&ingestThread);
+    QObject::connect(&ingestThread, &QThread::finished, ingest, &QObject::deleteLater);
+    QObject::connect(ingest, &TelemetryIngest::listenFailed, [&](const QString &error) {
+        QTextStream(stderr) << error << "\n";
+        app.exit(1);
+    });
+    ingestThread.start();
+    QTimer::singleShot(0, ingest, []() { trackedThread = IngestThread; });
+    QMetaObject::invokeMethod(ingest, "listen", Qt::QueuedConnection,
+                              Q_ARG(QString, QString("127.0.0.1")), Q_ARG(int, port),
+                              Q_ARG(int, int(TelemetryIngest::Tcp)));
+
+    QThread generatorThread;
+    LoadGenerator *generator = new LoadGenerator(connections, rate, parser.isSet("binary"));
+    generator->moveToThread(&generatorThread);
+    QObject::connect(&generatorThread, &QThread::finished, generator, &QObject::deleteLater);
+    generatorThread.start();
+    QTimer::singleShot(100, generator, [generator, port]() { generator->start(port); });
+
+    // 界面端：与 Server::drainSnapshots 相同的取数方式，记录从解析完成到界面取走的延迟
+    bool measuring = false;
+    QVector<qint64> latencies;
+    latencies.reserve(1 << 20);
+    quint64 uiSnapshots = 0;
+    QObject::connect(ingest, &TelemetryIngest::snapshotsReady, &app, [&]() {
+        ingest->rearmNotify();
+        TelemetrySnapshot snapshot;
+        while (ingest->takeSnapshot(snapshot)) {
+            if (!measuring)
+                continue;
+            latencies.append(Telemetry::monotonicNs() - snapshot.sample.timestampNs);
+            ++uiSnapshots;
+        }
+    });
+
+    quint64 startFrames = 0, startIngestAllocs = 0, startUiAllocs = 0;
+    QElapsedTimer clock;
+    QTimer::singleShot(1100, [&]() {
+        measuring = true;
+        startFrames = ingest->decodedFrames();
+        startIngestAllocs = allocations[IngestThread].load();
+        startUiAllocs = allocations[UiThread].load();
+        clock.start();
+    });
+    QTimer::singleShot(1100 + seconds * 1000, [&]() {
+        const double elapsed = clock.nsecsElapsed() / 1e9;
+        const quint64 frames = ingest->decodedFrames() - startFrames;
+        const quint64 ingestAllocs = allocations[IngestThread].load() - startIngestAllocs;
+        const quint64 uiAllocs = allocations[UiThread].load() - startUiAllocs;
+
+        QTextStream out(stdout);
+        out << "connections:            " << connections << (parser.isSet("binary") ? " (binary)" : " (json)") << "\n"
+            << "decoded:                " << quint64(frames / elapsed) << " msg/s\n"
+            << "to UI (active drone):   " << quint64(uiSnapshots / elapsed) << " msg/s\n"
+            << "ingest->UI latency us:  p50 " << percentile(latencies, 0.50)
+            << "  p99 " << percentile(latencies, 0.99)
+            << "  max " << percentile(latencies, 1.0) << "\n";
+        if (COUNT_ALLOCATIONS) {
+            out << "allocations per msg:    ingest " << (frames ? double(ingestAllocs) / frames : 0.0)
+                << "  ui " << (uiSnapshots ? double(uiAllocs) / uiSnapshots : 0.0) << "\n";
+        } else {
+            out << "allocations per msg:    n/a (needs glibc)\n";
+        }
+        out.flush();
+
+        generatorThread.quit();
+        generatorThread.wait();
+        ingestThread.quit();
+        ingestThread.wait();
+        app.quit();
+    });
+
+    return app.exec();
+}
@@ -0,0 +1,97 @@
+#include "telemetryparser.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QVector>
+
+// 原来 Server::updateServerProgress 的做法：
+// UTF-8 -> QString -> Local8Bit -> QJsonDocument，再按字符串键取值
+static double parseWithQJson(const QByteArray &frame, TelemetrySample &sample)
+{
+    QTextCodec *utf8codec = QTextCodec::codecForName("UTF-8");
+    QString utf8str = utf8codec->toUnicode(frame);
+    QJsonObject json = QJsonDocument::fromJson(utf8str.toLocal8Bit().data()).object();
+
+    QJsonObject gps = json["GPS"].toObject();
+    sample.longitude = gps["longitude"].toDouble();
+    sample.latitude  = gps["latitude"].toDouble();
+    sample.altitude  = gps["altitude"].toDouble();
+    sample.velocityX = gps["velocityX"].toDouble();
+    sample.velocityY = gps["velocityY"].toDouble();
+    sample.velocityZ = gps["velocityZ"].toDouble();
+    sample.yaw       = gps["yaw"].toDouble();
+    QJsonObject gimbal = json["Gimbal"].toObject();
+    sample.gimbalPitch = gimbal["pitch"].toDouble();
+    sample.gimbalRoll  = gimbal["roll"].toDouble();
+    sample.gimbalYaw   = gimbal["yaw"].toDouble();
+    sample.batteryPercent = json["Battery"].toObject()["BatteryEnergyRemainingPercent"].toDouble();
+    return sample.longitude;
+}
+
+static double parseWithTelemetryParser(const QByteArray &frame, TelemetrySample &sample)
+{
+    TelemetryParser::Result result;
+    TelemetryParser::parse(frame.constData(), frame.size(), sample, result);
+    return sample.longitude;
+}
+
+static QVector<QByteArray> makeMessages(int count)
+{
+    QVector<QByteArray> messages;
+    for (int i = 0; i < count; ++i) {
+        const double t = i * 0.02;
+        messages.append(QString(
+            "{\"DroneID\":\"M100-%1\","
+            "\"GPS\":{\"longitude\":%2,\"latitude\":%3,\"altitude\":%4,"
+            "\"velocityX\":%5,\"velocityY\":%6,\"velocityZ\":%7,\"yaw\":%8},"
+            "\"Gimbal\":{\"pitch\":%9,\"roll\":0.0,\"yaw\":%10},"
+            "\"Battery\":{\"BatteryEnergyRemainingPercent\":%11}}")
+            .arg(i % 4)
+            .arg(116.98 + t * 1e-5, 0, 'f', 8).arg(36.6169 + t * 1e-5, 0, 'f', 8)
+            .arg(120.0 + (i % 50) * 0.1, 0, 'f', 2)
+            .arg(3.25, 0, 'f', 2).arg(-1.5, 0, 'f', 2).arg(0.1 * (i % 7), 0, 'f', 2)
+            .arg(-179.0 + (i % 359), 0, 'f', 1)
+            .arg(-30.0 - (i % 60), 0, 'f', 1).arg(12.5, 0, 'f', 1)
+            .arg(100 - (i / 100) % 100)
+            .toUtf8());
+    }
+    return messages;
+}
+
+template <typename ParseFunction>
+static double messagesPerSecond(const QVector<QByteArray> &messages, int rounds,
+                                ParseFunction parse, double &checksum)
+{
+    TelemetrySample sample = TelemetrySample();
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < rounds; ++r)
+        for (int i = 0; i < messages.size(); ++i)
+            checksum += parse(messages[i], sample);
+    const double seconds = timer.nsecsElapsed() * 1e-9;
+    return messages.size() * double(rounds) / seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int rounds = argc > 1 ? QByteArray(argv[1]).toInt() : 50;
+
+    const QVector<QByteArray> messages = makeMessages(10000);
+    double checksum = 0;
+
+    const double qjson = messagesPerSecond(messages, rounds, parseWithQJson, checksum);
+    const double sax   = messagesPerSecond(messages, rounds, parseWithTelemetryParser, checksum);
+
+    QTextStream out(stdout);
+    out << "messages:        " << messages.size() * rounds << "\n";
+    out << "QJsonDocument:   " << qRound64(qjson) << " msg/s\n";
+    out << "TelemetryParser: " << qRound64(sax) << " msg/s\n";
+    out << "speedup:         " << sax / qjson << "x\n";
+    out << "(checksum " << checksum << ")\n";
+    return 0;
+}
@@ -0,0 +1,16 @@
+# 遥测解析基准：TelemetryParser 与原来的 QJsonDocument 路径对比
+QT += core
+QT -= gui
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = parserbench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../telemetryparser.cpp
+
+HEADERS += ../../telemetryparser.h \
+    ../../telemetrysample.h
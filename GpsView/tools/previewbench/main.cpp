@@ -0,0 +1,66 @@
+#include "previewkernel.h"
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QTextStream>
+#include <QVector>
+
+// 原来 MainWindow::readFarme 的做法
+static QImage qtPath(const QVector<uchar> &frame, int width, int height, Qt::TransformationMode mode)
+{
+    return QImage(frame.constData(), width, height, width * 3, QImage::Format_RGB888)
+            .rgbSwapped().scaled(400, 400, Qt::KeepAspectRatio, mode);
+}
+
+template <typename Function>
+static double millisecondsPerFrame(int rounds, Function function)
+{
+    function();     // 预热
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < rounds; ++i)
+        function();
+    return timer.nsecsElapsed() * 1e-6 / rounds;
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    const int rounds = argc > 1 ? QByteArray(argv[1]).toInt() : 100;
+
+    static const int resolutions[][2] = { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+    QTextStream out(stdout);
+    out << "ms per frame, " << rounds << " rounds\n";
+
+    for (const auto &resolution : resolutions) {
+        const int width = resolution[0], height = resolution[1];
+        QVector<uchar> frame(width * height * 3);
+        for (int i = 0; i < frame.size(); ++i)
+            frame[i] = uchar((i * 2654435761u) >> 24);
+
+        int dstWidth, dstHeight;
+        PreviewKernel::fitSize(width, height, 400, 400, dstWidth, dstHeight);
+        QImage preview(dstWidth, dstHeight, QImage::Format_RGB888);
+
+        out << width << "x" << height << " -> " << dstWidth << "x" << dstHeight << "\n";
+        out << "  Qt rgbSwapped+scaled (fast)   "
+            << millisecondsPerFrame(rounds, [&]() { qtPath(frame, width, height, Qt::FastTransformation); }) << "\n";
+        out << "  Qt rgbSwapped+scaled (smooth) "
+            << millisecondsPerFrame(rounds, [&]() { qtPath(frame, width, height, Qt::SmoothTransformation); }) << "\n";
+
+        for (int i = PreviewKernel::Scalar; i <= PreviewKernel::AVX2; ++i) {
+            const PreviewKernel::Implementation implementation = PreviewKernel::Implementation(i);
+            if (!PreviewKernel::isSupported(implementation))
+                continue;
+            out << "  PreviewKernel " << qSetFieldWidth(16) << left << PreviewKernel::name(implementation)
+                << qSetFieldWidth(0)
+                << millisecondsPerFrame(rounds, [&]() {
+                       PreviewKernel::bgrToRgbArea(frame.constData(), width, height, width * 3,
+                                                   preview.bits(), dstWidth, dstHeight,
+                                                   preview.bytesPerLine(), implementation);
+                   }) << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+# 预览缩放基准：PreviewKernel 与 rgbSwapped().scaled() 对比
+QT += core gui
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = previewbench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../previewkernel.cpp
+
+HEADERS += ../../previewkernel.h
@@ -0,0 +1,146 @@
+#include "telemetrygen.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QTextStream>
+#include <QVector>
+
+// 一个模拟连接：各自的 DroneID 和序号
+struct Connection
+{
+    QTcpSocket *socket;
+    QByteArray id;
+    quint32 sequence;
+    bool connected;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Send simulated telemetry to GpsView.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("host", "Ground station address.", "host", "127.0.0.1"));
+    parser.addOption(QCommandLineOption("port", "Ground station port.", "port", "6666"));
+    parser.addOption(QCommandLineOption("rate", "Messages per second per connection (0 = as fast as possible).", "hz", "50"));
+    parser.addOption(QCommandLineOption("count", "Stop after N messages per connection (0 = forever).", "n", "0"));
+    parser.addOption(QCommandLineOption("id", "DroneID to report; numbered when there are several connections.", "id", "SIM-1"));
+    parser.addOption(QCommandLineOption("connections", "Number of simulated aircraft.", "n", "1"));
+    parser.addOption(QCommandLineOption("binary", "Use the compact binary format instead of JSON."));
+    parser.addOption(QCommandLineOption("udp", "Send UDP datagrams instead of a TCP stream."));
+    parser.process(app);
+
+    const QString host = parser.value("host");
+    const quint16 port = quint16(parser.value("port").toUInt());
+    const double rate = qMax(0.0, parser.value("rate").toDouble());
+    const quint32 count = parser.value("count").toUInt();
+    const int connections = qMax(1, parser.value("connections").toInt());
+    const bool binary = parser.isSet("binary");
+    const bool udp = parser.isSet("udp");
+    // 模拟轨迹按报文序号计算，不限速时按 50 Hz 推算
+    const double simulatedRate = rate > 0 ? rate : 50.0;
+
+    QTextStream out(stdout);
+    QUdpSocket udpSocket;
+    const QHostAddress address(host);
+
+    QVector<Connection> drones(connections);
+    for (int i = 0; i < connections; ++i) {
+        Connection &c = drones[i];
+        c.id = parser.value("id").toUtf8();
+        if (connections > 1)
+            c.id += "-" + QByteArray::number(i + 1);
+        c.sequence = 0;
+        c.connected = udp;
+        c.socket = 0;
+    }
+
+    int open = connections;
+    auto finishOne = [&]() {
+        if (--open == 0)
+            app.quit();
+    };
+
+    // 发送一条；TCP 发送缓冲区积压时返回 false，不限速时以此作为背压
+    auto sendOne = [&](Connection &c) {
+        if (!udp && c.socket->bytesToWrite() > 256 * 1024)
+            return false;
+        TelemetrySample s = simulate(c.sequence, simulatedRate);
+        s.sentMs = double(QDateTime::currentMSecsSinceEpoch());
+        const QByteArray payload = binary ? encodeBinary(s, c.id, c.sequence) : encodeJson(s, c.id);
+        if (udp)
+            udpSocket.writeDatagram(datagram(payload, c.sequence), address, port);
+        else
+            c.socket->write(frame(payload));
+
+        if (++c.sequence == count) {
+            c.connected = false;
+            if (udp)
+                finishOne();
+            else
+                c.socket->disconnectFromHost();
+        }
+        return true;
+    };
+
+    // 每毫秒检查一次，按开始以来的时间补发到应发的条数，定时器抖动不会降低速率
+    QTimer timer;
+    timer.setTimerType(Qt::PreciseTimer);
+    QElapsedTimer clock;
+    quint64 sentTotal = 0, reportedTotal = 0;
+    qint64 reportedMs = 0;
+    QObject::connect(&timer, &QTimer::timeout, [&]() {
+        const double elapsed = clock.nsecsElapsed() / 1e9;
+        for (int i = 0; i < drones.size(); ++i) {
+            Connection &c = drones[i];
+            if (!c.connected)
+                continue;
+            const quint64 due = rate > 0 ? quint64(elapsed * rate) + 1 : c.sequence + 1000;
+            while (c.connected && c.sequence < due && sendOne(c))
+                ++sentTotal;
+        }
+
+        if (clock.elapsed() - reportedMs >= 1000) {
+            out << "sent " << (sentTotal - reportedTotal) * 1000 / quint64(clock.elapsed() - reportedMs)
+                << " msg/s over " << connections << " connection(s)\n";
+            out.flush();
+            reportedTotal = sentTotal;
+            reportedMs = clock.elapsed();
+        }
+    });
+
+    if (udp) {
+        clock.start();
+        timer.start(1);
+        return app.exec();
+    }
+
+    int pending = connections;
+    for (int i = 0; i < drones.size(); ++i) {
+        Connection &c = drones[i];
+        c.socket = new QTcpSocket(&app);
+        QObject::connect(c.socket, &QTcpSocket::connected, [&, i]() {
+            drones[i].connected = true;
+            // 全部连上以后一起开始
+            if (--pending == 0) {
+                clock.start();
+                timer.start(1);
+            }
+        });
+        QObject::connect(c.socket, &QTcpSocket::disconnected, finishOne);
+        QObject::connect(c.socket, static_cast<void (QTcpSocket::*)(QAbstractSocket::SocketError)>(&QTcpSocket::error),
+                         [&, i]() {
+            QTextStream(stderr) << drones[i].id << ": " << drones[i].socket->errorString() << "\n";
+            app.exit(1);
+        });
+        c.socket->connectToHost(host, port);
+    }
+    return app.exec();
+}
@@ -0,0 +1,80 @@
+#ifndef TELEMETRYGEN_H
+#define TELEMETRYGEN_H
+
+#include "telemetrybinary.h"
+
+#include <QByteArray>
+#include <QtEndian>
+
+#include <cmath>
+
+// 模拟飞机的遥测数据和各种分帧方式，发送工具和接收基准共用
+
+// 在 (lat0, lng0) 附近绕圈飞行的模拟轨迹
+inline TelemetrySample simulate(quint32 n, double rate)
+{
+    const double lat0 = 36.6169, lng0 = 116.98;
+    const double radius = 200.0, speed = 10.0;        // m, m/s
+    const double t = n / rate;
+    const double w = speed / radius;
+    const double metersPerDegree = 111320.0;
+
+    TelemetrySample s = TelemetrySample();
+    s.latitude  = lat0 + radius * std::sin(w * t) / metersPerDegree;
+    s.longitude = lng0 + radius * std::cos(w * t) / (metersPerDegree * std::cos(lat0 * M_PI / 180.0));
+    s.altitude  = 120.0 + 5.0 * std::sin(t * 0.1);
+    s.velocityX = speed * std::cos(w * t);             // 北
+    s.velocityY = -speed * std::sin(w * t);            // 东
+    s.velocityZ = -0.5 * std::cos(t * 0.1);            // 向下为正（NED）
+    s.yaw       = std::atan2(s.velocityY, s.velocityX) * 180.0 / M_PI;
+    s.gimbalPitch = -90.0;
+    s.gimbalYaw   = s.yaw;
+    s.batteryPercent = qMax(0.0, 100.0 - t / 36.0);
+    return s;
+}
+
+// sentMs 不为 0 时带上发送时刻，接收端据此估计链路延迟
+inline QByteArray encodeJson(const TelemetrySample &s, const QByteArray &id)
+{
+    return "{\"DroneID\":\"" + id + "\","
+           "\"GPS\":{" + (s.sentMs > 0 ? "\"timestamp\":" + QByteArray::number(qint64(s.sentMs)) + "," : QByteArray())
+           + "\"longitude\":" + QByteArray::number(s.longitude, 'f', 8)
+           + ",\"latitude\":" + QByteArray::number(s.latitude, 'f', 8)
+           + ",\"altitude\":" + QByteArray::number(s.altitude, 'f', 2)
+           + ",\"velocityX\":" + QByteArray::number(s.velocityX, 'f', 2)
+           + ",\"velocityY\":" + QByteArray::number(s.velocityY, 'f', 2)
+           + ",\"velocityZ\":" + QByteArray::number(s.velocityZ, 'f', 2)
+           + ",\"yaw\":" + QByteArray::number(s.yaw, 'f', 1) + "},"
+           "\"Gimbal\":{\"pitch\":" + QByteArray::number(s.gimbalPitch, 'f', 1)
+           + ",\"roll\":" + QByteArray::number(s.gimbalRoll, 'f', 1)
+           + ",\"yaw\":" + QByteArray::number(s.gimbalYaw, 'f', 1) + "},"
+           "\"Battery\":{\"BatteryEnergyRemainingPercent\":"
+           + QByteArray::number(qRound(s.batteryPercent)) + "}}";
+}
+
+inline QByteArray encodeBinary(const TelemetrySample &s, const QByteArray &id, quint32 sequence)
+{
+    char buffer[TelemetryBinary::MaxFrameSize];
+    const int size = TelemetryBinary::encode(s, TelemetrySample::GPS | TelemetrySample::Gimbal
+                                             | TelemetrySample::Battery, sequence,
+                                             id.constData(), id.size(), buffer, sizeof(buffer));
+    return QByteArray(buffer, size);
+}
+
+// writeUTF 分帧：2 字节大端长度 + 数据
+inline QByteArray frame(const QByteArray &payload)
+{
+    uchar head[2];
+    qToBigEndian<quint16>(quint16(payload.size()), head);
+    return QByteArray(reinterpret_cast<const char *>(head), 2) + payload;
+}
+
+// UDP 数据包：u32 小端序号 + 报文
+inline QByteArray datagram(const QByteArray &payload, quint32 sequence)
+{
+    uchar head[4];
+    qToLittleEndian<quint32>(sequence, head);
+    return QByteArray(reinterpret_cast<const char *>(head), 4) + payload;
+}
+
+#endif // TELEMETRYGEN_H
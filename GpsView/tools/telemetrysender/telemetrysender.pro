@@ -0,0 +1,18 @@
+# 遥测发送端：模拟一架或多架飞机向地面站 6666 端口发送 JSON 或二进制遥测，也用作压力测试
+QT += core network
+QT -= gui
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = telemetrysender
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../telemetrybinary.cpp
+
+HEADERS += telemetrygen.h \
+    ../../telemetrybinary.h \
+    ../../telemetryparser.h \
+    ../../telemetrysample.h
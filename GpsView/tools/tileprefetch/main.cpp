@@ -0,0 +1,153 @@
+#include "mapcache.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QQueue>
+
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+// 百度瓦片服务器，%1 为 0-4 的分流编号
+static const char *tileServer =
+        "http://online%1.map.bdimg.com/onlinelabel/?qt=tile&x=%2&y=%3&z=%4&styles=pl&scaler=1&p=1";
+
+struct Tile { int z, x, y; };
+
+// 百度瓦片按 BD09MC（百度墨卡托）编号，它不是球面墨卡托：纬度方向按纬度带用多项式拟合，
+// 40°N 附近两者相差约 25 km。系数和分带与百度 JS API 的 convertLL2MC 相同
+static const double llBand[6] = { 75, 60, 45, 30, 15, 0 };
+static const double ll2mc[6][10] = {
+    { -0.0015702102444, 111320.7020616939, 1704480524535203, -10338987376042340, 26112667856603880,
+      -35149669176653700, 26595700718403920, -10725012454188240, 1800819912950474, 82.5 },
+    { 0.0008277824516172526, 111320.7020463578, 647795574.6671607, -4082003173.641316, 10774905663.51142,
+      -15171875531.51559, 12053065338.62167, -5124939663.577472, 913311935.9512032, 67.5 },
+    { 0.00337398766765, 111320.7020202162, 4481351.045890365, -23393751.19931662, 79682215.47186455,
+      -115964993.2797253, 97236711.15602145, -43661946.33752821, 8477230.501135234, 52.5 },
+    { 0.00220636496208, 111320.7020209128, 51751.86112841131, 3796837.749470245, 992013.7397791013,
+      -1221952.21711287, 1340652.697009075, -620943.6990984312, 144416.9293806241, 37.5 },
+    { -0.0003441963504368392, 111320.7020576856, 278.2353980772752, 2485758.690035394, 6070.750963243378,
+      54821.18345352118, 9540.606633304236, -2710.55326746645, 1405.483844121726, 22.5 },
+    { -0.0003218135878613132, 111320.7020701615, 0.00369383431289, 823725.6402795718, 0.46104986909093,
+      2351.343141331292, 1.58060784298199, 8.77738589078284, 0.37238884252424, 7.45 }
+};
+
+// BD-09 经纬度 -> BD09MC 平面坐标（米）
+static void toMercator(double lng, double lat, double &mx, double &my)
+{
+    lat = std::max(-74.0, std::min(74.0, lat));
+    const double *c = ll2mc[5];
+    for (int i = 0; i < 6; ++i) {
+        if (std::fabs(lat) >= llBand[i]) {
+            c = ll2mc[i];
+            break;
+        }
+    }
+
+    const double t = std::fabs(lat) / c[9];
+    mx = c[0] + c[1] * std::fabs(lng);
+    my = c[2] + t * (c[3] + t * (c[4] + t * (c[5] + t * (c[6] + t * (c[7] + t * c[8])))));
+    if (lng < 0)
+        mx = -mx;
+    if (lat < 0)
+        my = -my;
+}
+
+// 18 级一个像素对应 1 个 BD09MC 单位，瓦片 256 像素
+static void tileAt(double lng, double lat, int z, int &x, int &y)
+{
+    double mx, my;
+    toMercator(lng, lat, mx, my);
+    const double scale = std::pow(2.0, z - 18) / 256.0;
+    x = int(std::floor(mx * scale));
+    y = int(std::floor(my * scale));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Download Baidu map tiles into the GpsView offline cache.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("bounds", "Area in map (BD-09) coordinates.", "west,south,east,north"));
+    parser.addOption(QCommandLineOption("zoom", "Zoom range.", "min-max", "12-18"));
+    parser.addOption(QCommandLineOption("cache", "Cache directory.", "dir", "bin/cache"));
+    parser.addOption(QCommandLineOption("parallel", "Concurrent downloads.", "n", "6"));
+    parser.process(app);
+
+    QTextStream out(stdout);
+    const QStringList bounds = parser.value("bounds").split(',');
+    const QStringList zoom = parser.value("zoom").split('-');
+    if (bounds.size() != 4 || zoom.size() != 2)
+        parser.showHelp(1);
+
+    const double west = bounds[0].toDouble(), south = bounds[1].toDouble();
+    const double east = bounds[2].toDouble(), north = bounds[3].toDouble();
+    const int minZoom = zoom[0].toInt(), maxZoom = zoom[1].toInt();
+    const QString root = parser.value("cache");
+
+    // 只排队本地还没有的瓦片
+    QQueue<Tile> queue;
+    int skipped = 0;
+    for (int z = minZoom; z <= maxZoom; ++z) {
+        int x0, y0, x1, y1;
+        tileAt(west, south, z, x0, y0);
+        tileAt(east, north, z, x1, y1);
+        for (int x = x0; x <= x1; ++x) {
+            for (int y = y0; y <= y1; ++y) {
+                if (QFileInfo::exists(root + '/' + MapCache::tilePath(z, x, y))) {
+                    ++skipped;
+                    continue;
+                }
+                Tile tile = { z, x, y };
+                queue.enqueue(tile);
+            }
+        }
+    }
+    out << queue.size() << " tiles to download, " << skipped << " already cached\n";
+    out.flush();
+    if (queue.isEmpty())
+        return 0;
+
+    MapCache cache(root);
+    QNetworkAccessManager network;
+    const int total = queue.size();
+    int finished = 0, failed = 0, running = 0;
+
+    std::function<void()> next = [&]() {
+        while (running < parser.value("parallel").toInt() && !queue.isEmpty()) {
+            const Tile tile = queue.dequeue();
+            const QUrl url(QString(tileServer).arg(qAbs(tile.x + tile.y) % 5)
+                           .arg(tile.x).arg(tile.y).arg(tile.z));
+            QNetworkRequest request(url);
+            request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+            QNetworkReply *reply = network.get(request);
+            ++running;
+            QObject::connect(reply, &QNetworkReply::finished, [&, reply, url]() {
+                reply->deleteLater();
+                --running;
+                ++finished;
+                const QByteArray data = reply->readAll();
+                if (reply->error() != QNetworkReply::NoError || data.isEmpty()
+                        || !cache.store(url, data, "image/png"))
+                    ++failed;
+                if (finished % 100 == 0 || finished == total) {
+                    out << finished << "/" << total << " (" << failed << " failed)\n";
+                    out.flush();
+                }
+                if (finished == total)
+                    app.exit(failed ? 2 : 0);
+                else
+                    next();
+            });
+        }
+    };
+    next();
+
+    return app.exec();
+}
@@ -0,0 +1,15 @@
+# 飞行前预先下载指定区域和缩放级别的地图瓦片到离线缓存
+QT += core network
+QT -= gui
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = tileprefetch
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../mapcache.cpp
+
+HEADERS += ../../mapcache.h
@@ -0,0 +1,8 @@
+# 辅助工具，与 GpsView 主程序分开构建
+TEMPLATE = subdirs
+
+SUBDIRS += parserbench \
+    telemetrysender \
+    previewbench \
+    tileprefetch \
+    ingestbench
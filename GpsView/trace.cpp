@@ -0,0 +1,147 @@
+#include "trace.h"
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QVector>
+#include <QThread>
+#include <QFile>
+
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    qint64 startNs;
+    qint64 endNs;
+    quint64 id;
+};
+
+struct ThreadTrace
+{
+    QString threadName;
+    int tid;
+    QAtomicInteger<quint32> head;      // 已写入的事件总数，只有所属线程写
+    Event events[Trace::Capacity];
+};
+
+QAtomicInt enabledFlag;
+
+QMutex &registryLock()
+{
+    static QMutex lock;
+    return lock;
+}
+
+// 线程退出后缓冲区保留，导出时仍能看到它最后的事件
+QVector<ThreadTrace *> &registry()
+{
+    static QVector<ThreadTrace *> traces;
+    return traces;
+}
+
+ThreadTrace *threadTrace()
+{
+    static thread_local ThreadTrace *trace = 0;
+    if (!trace) {
+        trace = new ThreadTrace;
+        trace->head.store(0);
+        QThread *thread = QThread::currentThread();
+        QMutexLocker locker(&registryLock());
+        trace->tid = registry().size() + 1;
+        trace->threadName = thread && !thread->objectName().isEmpty()
+                ? thread->objectName() : QString("thread %1").arg(trace->tid);
+        registry().append(trace);
+    }
+    return trace;
+}
+
+void appendEscaped(QByteArray &out, const QByteArray &text)
+{
+    for (int i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+}
+
+} // namespace
+
+namespace Trace {
+
+void setEnabled(bool enabled)
+{
+    enabledFlag.storeRelease(enabled);
+}
+
+bool isEnabled()
+{
+    return enabledFlag.loadAcquire();
+}
+
+void record(const char *name, qint64 startNs, qint64 endNs, quint64 id)
+{
+    ThreadTrace *trace = threadTrace();
+    const quint32 h = trace->head.load();
+    Event &e = trace->events[h % Capacity];
+    e.name = name;
+    e.startNs = startNs;
+    e.endNs = endNs;
+    e.id = id;
+    trace->head.storeRelease(h + 1);
+}
+
+bool dump(const QString &fileName)
+{
+    QByteArray json;
+    json.reserve(1 << 20);
+    json += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    QMutexLocker locker(&registryLock());
+    const QVector<ThreadTrace *> &traces = registry();
+    bool first = true;
+    for (int t = 0; t < traces.size(); ++t) {
+        ThreadTrace *trace = traces[t];
+
+        if (!first)
+            json += ",\n";
+        first = false;
+        json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + QByteArray::number(trace->tid)
+                + ",\"args\":{\"name\":\"";
+        appendEscaped(json, trace->threadName.toUtf8());
+        json += "\"}}";
+
+        // 先复制再检查：复制期间被所属线程覆盖的旧事件丢弃
+        const quint32 end = trace->head.loadAcquire();
+        const quint32 begin = end > quint32(Capacity) ? end - Capacity : 0;
+        QVector<Event> events;
+        events.reserve(int(end - begin));
+        for (quint32 i = begin; i != end; ++i)
+            events.append(trace->events[i % Capacity]);
+        // 所属线程可能正在写第 after 个事件，它占用的是第 after - Capacity 个的位置
+        const quint32 after = trace->head.loadAcquire();
+        const quint32 valid = after >= quint32(Capacity) ? after - Capacity + 1 : 0;
+
+        for (int i = 0; i < events.size(); ++i) {
+            if (begin + quint32(i) < valid)
+                continue;
+            const Event &e = events[i];
+            json += ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" + QByteArray::number(trace->tid)
+                    + ",\"name\":\"" + e.name
+                    + "\",\"ts\":" + QByteArray::number(e.startNs / 1000.0, 'f', 3)
+                    + ",\"dur\":" + QByteArray::number((e.endNs - e.startNs) / 1000.0, 'f', 3);
+            if (e.id)
+                json += ",\"args\":{\"id\":" + QByteArray::number(e.id) + "}";
+            json += "}";
+        }
+    }
+    json += "\n]}\n";
+    locker.unlock();
+
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(json) == json.size();
+}
+
+} // namespace Trace
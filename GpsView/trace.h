@@ -0,0 +1,49 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+
+#include "telemetrysample.h"
+
+// 流水线跟踪：记录各阶段的起止时间（Telemetry::monotonicNs），
+// 导出为 Chrome trace JSON，可以在 chrome://tracing 或 Perfetto 中查看单条报文、单帧的耗时。
+// 每个线程有自己的环形缓冲区，只保留最近 Capacity 个事件；
+// 未开启时 Span 只有一次原子读，可以一直留在热路径上。
+namespace Trace {
+
+enum { Capacity = 16384 };     // 每个线程
+
+void setEnabled(bool enabled);
+bool isEnabled();
+
+// name 必须是字符串常量；id 为报文序号或帧号，方便在 Perfetto 中对应
+void record(const char *name, qint64 startNs, qint64 endNs, quint64 id);
+
+// 写出所有线程缓冲区中的事件，线程名取自 QThread::objectName()
+bool dump(const QString &fileName);
+
+// 作用域内的一段耗时
+class Span
+{
+public:
+    explicit Span(const char *name, quint64 id = 0)
+        : spanName(name), spanId(id), startNs(isEnabled() ? Telemetry::monotonicNs() : 0) {}
+    ~Span()
+    {
+        if (startNs)
+            record(spanName, startNs, Telemetry::monotonicNs(), spanId);
+    }
+
+    void setId(quint64 id) { spanId = id; }
+
+private:
+    Q_DISABLE_COPY(Span)
+
+    const char *spanName;
+    quint64 spanId;
+    qint64 startNs;
+};
+
+} // namespace Trace
+
+#endif // TRACE_H
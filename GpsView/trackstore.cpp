@@ -0,0 +1,220 @@
+#include "trackstore.h"
+
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+// 球面墨卡托，单位米；与百度墨卡托相差很小，只用于衡量简化误差
+inline void project(double lng, double lat, double &x, double &y)
+{
+    const double R = 6378137.0;
+    x = R * lng * M_PI / 180.0;
+    y = R * std::log(std::tan(M_PI / 4.0 + lat * M_PI / 360.0));
+}
+
+// 点 (px, py) 到线段 (ax, ay)-(bx, by) 距离的平方
+inline double segmentDistance2(double px, double py, double ax, double ay, double bx, double by)
+{
+    const double dx = bx - ax, dy = by - ay;
+    const double length2 = dx * dx + dy * dy;
+    double t = length2 > 0 ? ((px - ax) * dx + (py - ay) * dy) / length2 : 0;
+    t = qBound(0.0, t, 1.0);
+    const double ex = ax + t * dx - px, ey = ay + t * dy - py;
+    return ex * ex + ey * ey;
+}
+
+inline bool intersects(double west, double south, double east, double north,
+                       double w, double s, double e, double n)
+{
+    return w <= east && e >= west && s <= north && n >= south;
+}
+
+} // namespace
+
+TrackStore::TrackStore()
+{
+    // 18 级时一个像素约 1 米，每升一级减半
+    for (int i = 0; i < LevelCount; ++i)
+        levels[i].tolerance = 0.5 * std::pow(2.0, 18 - (MinZoom + i));
+}
+
+void TrackStore::clear()
+{
+    raw.clear();
+    for (int i = 0; i < LevelCount; ++i) {
+        levels[i].points.clear();
+        levels[i].segments.clear();
+    }
+}
+
+void TrackStore::append(const double *lng, const double *lat, int count)
+{
+    if (count <= 0)
+        return;
+
+    if (raw.isEmpty()) {
+        for (int i = 0; i < LevelCount; ++i)
+            levels[i].points.append(0);
+    }
+    for (int i = 0; i < count; ++i) {
+        Point p = { lng[i], lat[i] };
+        raw.append(p);
+    }
+
+    // 最细一级直接从原始点简化
+    Level &finest = levels[LevelCount - 1];
+    if (raw.size() - 1 - finest.points.last() >= ChunkPoints) {
+        QVector<int> input;
+        input.reserve(raw.size() - finest.points.last());
+        for (int i = finest.points.last(); i < raw.size(); ++i)
+            input.append(i);
+        simplify(LevelCount - 1, input);
+    }
+
+    // 粗一级从细一级的结果中简化，细一级没有新的块时更粗的级别也不会有
+    for (int l = LevelCount - 2; l >= 0; --l) {
+        const QVector<int> &source = levels[l + 1].points;
+        const int from = int(std::lower_bound(source.begin(), source.end(), levels[l].points.last())
+                             - source.begin());
+        if (source.size() - 1 - from < ChunkPoints)
+            break;
+        simplify(l, source.mid(from));
+    }
+}
+
+// input 的首点已在该级别中，简化后把其余保留的点接在后面，作为一个新块
+void TrackStore::simplify(int level, const QVector<int> &input)
+{
+    Level &lv = levels[level];
+    const int n = input.size();
+
+    QVector<double> x(n), y(n);
+    Segment segment;
+    segment.west = segment.east = raw[input[0]].lng;
+    segment.south = segment.north = raw[input[0]].lat;
+    for (int i = 0; i < n; ++i) {
+        const Point &p = raw[input[i]];
+        project(p.lng, p.lat, x[i], y[i]);
+        segment.west = qMin(segment.west, p.lng);
+        segment.east = qMax(segment.east, p.lng);
+        segment.south = qMin(segment.south, p.lat);
+        segment.north = qMax(segment.north, p.lat);
+    }
+
+    QVector<char> keep(n, 0);
+    keep[0] = keep[n - 1] = 1;
+    const double tolerance2 = lv.tolerance * lv.tolerance;
+
+    QVector<QPair<int, int> > stack;
+    stack.append(qMakePair(0, n - 1));
+    while (!stack.isEmpty()) {
+        const QPair<int, int> range = stack.takeLast();
+        const int a = range.first, b = range.second;
+        double farthest = 0;
+        int index = -1;
+        for (int i = a + 1; i < b; ++i) {
+            const double d = segmentDistance2(x[i], y[i], x[a], y[a], x[b], y[b]);
+            if (d > farthest) {
+                farthest = d;
+                index = i;
+            }
+        }
+        if (index < 0 || farthest <= tolerance2)
+            continue;
+        keep[index] = 1;
+        stack.append(qMakePair(a, index));
+        stack.append(qMakePair(index, b));
+    }
+
+    for (int i = 1; i < n; ++i) {
+        if (keep[i])
+            lv.points.append(input[i]);
+    }
+    segment.end = lv.points.size() - 1;
+    lv.segments.append(segment);
+}
+
+QVariantList TrackStore::query(int zoom, double west, double south, double east, double north) const
+{
+    // 视野四周留一些余量，拖动时边缘的轨迹不会突然出现
+    const double marginX = (east - west) * 0.1, marginY = (north - south) * 0.1;
+    west -= marginX;
+    east += marginX;
+    south -= marginY;
+    north += marginY;
+
+    // 航迹在视野内反复往返时点数可能很多，逐级变粗直到页面能承受
+    int points = 0;
+    for (int l = qBound(0, zoom - MinZoom, LevelCount - 1); ; --l) {
+        const QVariantList runs = query(l, west, south, east, north, points);
+        if (points <= MaxQueryPoints || l == 0)
+            return runs;
+    }
+}
+
+QVariantList TrackStore::query(int level, double west, double south, double east, double north, int &points) const
+{
+    QVariantList runs;
+    points = 0;
+    if (raw.isEmpty())
+        return runs;
+
+    QVariantList run;
+    // 把 indices[from..to] 作为一段连续的折线接到当前 run 上，不在视野内时结束当前 run
+    auto emitRange = [&](const int *indices, int from, int to, bool visible) {
+        if (!visible) {
+            if (run.size() >= 4)
+                runs.append(QVariant(run));
+            run.clear();
+            return;
+        }
+        for (int i = run.isEmpty() ? from : from + 1; i <= to; ++i) {
+            run << raw[indices[i]].lng << raw[indices[i]].lat;
+            ++points;
+        }
+    };
+
+    // 先用所选级别，再依次用更细的级别补上还没简化到的部分
+    int cursor = 0;
+    for (int l = level; l < LevelCount; ++l) {
+        const Level &lv = levels[l];
+        if (lv.points.last() <= cursor)
+            continue;
+
+        const int start = int(std::lower_bound(lv.points.begin(), lv.points.end(), cursor)
+                              - lv.points.begin());
+        for (int s = 0; s < lv.segments.size(); ++s) {
+            const Segment &segment = lv.segments[s];
+            if (segment.end <= start)
+                continue;
+            const int from = qMax(start, s > 0 ? lv.segments[s - 1].end : 0);
+            emitRange(lv.points.constData(), from, segment.end,
+                      intersects(west, south, east, north,
+                                 segment.west, segment.south, segment.east, segment.north));
+            if (points > MaxQueryPoints)
+                return runs;        // 调用方会改用粗一级
+        }
+        cursor = lv.points.last();
+    }
+
+    // 最后是还没有简化的原始点
+    if (cursor < raw.size() - 1) {
+        QVector<int> tail;
+        double w = raw[cursor].lng, e = w, s = raw[cursor].lat, n = s;
+        for (int i = cursor; i < raw.size(); ++i) {
+            tail.append(i);
+            w = qMin(w, raw[i].lng);
+            e = qMax(e, raw[i].lng);
+            s = qMin(s, raw[i].lat);
+            n = qMax(n, raw[i].lat);
+        }
+        emitRange(tail.constData(), 0, tail.size() - 1, intersects(west, south, east, north, w, s, e, n));
+    }
+
+    if (run.size() >= 4)
+        runs.append(QVariant(run));
+    return runs;
+}
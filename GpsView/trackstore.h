@@ -0,0 +1,63 @@
+#ifndef TRACKSTORE_H
+#define TRACKSTORE_H
+
+#include <QVector>
+#include <QVariantList>
+
+// 飞行轨迹：保存全部原始点，并为每个缩放级别维护一份 Douglas-Peucker 简化结果。
+// 简化按块增量进行：最细一级每攒够 ChunkPoints 个新点简化一次，
+// 较粗一级再从细一级的结果中每攒够 ChunkPoints 个点简化一次，
+// 所以粗级别的块覆盖很长一段航迹，新点的开销与总点数无关。
+// 尚未简化到的部分在查询时用更细一级（最后是原始点）补上。
+class TrackStore
+{
+public:
+    enum {
+        MinZoom = 3,            // 百度地图的缩放范围
+        MaxZoom = 19,
+        ChunkPoints = 256,
+        MaxQueryPoints = 20000  // 单次查询最多的点数，超出时改用粗一级
+    };
+
+    TrackStore();
+
+    // 经纬度为地图坐标（BD-09）
+    void append(const double *lng, const double *lat, int count);
+    void clear();
+    int size() const { return raw.size(); }
+
+    // 返回与视野相交的各段折线，每段为 [lng, lat, lng, lat, ...]。
+    // 点的疏密按 zoom 级别取半个像素的误差
+    QVariantList query(int zoom, double west, double south, double east, double north) const;
+
+private:
+    struct Point
+    {
+        double lng;
+        double lat;
+    };
+
+    // 一次简化的结果：points 中 (上一块的 end, end] 这些点，以及对应原始航迹的范围
+    struct Segment
+    {
+        int end;
+        double west, south, east, north;
+    };
+
+    struct Level
+    {
+        QVector<int> points;        // 保留下来的原始点下标，递增
+        QVector<Segment> segments;
+        double tolerance;           // 投影坐标下的允许误差，米
+    };
+
+    enum { LevelCount = MaxZoom - MinZoom + 1 };
+
+    void simplify(int level, const QVector<int> &input);
+    QVariantList query(int level, double west, double south, double east, double north, int &points) const;
+
+    QVector<Point> raw;
+    Level levels[LevelCount];
+};
+
+#endif // TRACKSTORE_H
@@ -0,0 +1,241 @@
+#include "videorecorder.h"
+#include "telemetrysample.h"
+#include "perfstats.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+#include <cstring>
+
+
+VideoRecorder::VideoRecorder(QObject *parent)
+    : QThread(parent),
+      framesPerSecond(30),
+      startedNs(0)
+{
+    setObjectName("video recorder");
+
+    // 帧池开始时全部归采集线程，之后只在两个队列之间流转
+    for (int i = 0; i < PoolSize; ++i) {
+        poolTimes[i] = 0;
+        freeSlots.push(i);
+    }
+}
+
+VideoRecorder::~VideoRecorder()
+{
+    stopRecording();
+}
+
+bool VideoRecorder::startRecording(const QString &videoFile, const QString &indexFileName, double fps)
+{
+    stopRecording();
+
+    dropped.storeRelease(0);
+
+    indexFile.setFileName(indexFileName);
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    char header[IndexHeaderSize];
+    memcpy(header, "GVVI", 4);
+    qToLittleEndian<quint32>(Version, reinterpret_cast<uchar *>(header + 4));
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), reinterpret_cast<uchar *>(header + 8));
+    qToLittleEndian<qint64>(Telemetry::monotonicNs(), reinterpret_cast<uchar *>(header + 16));
+    indexFile.write(header, IndexHeaderSize);
+
+    // 编码器在第一帧到达时按其尺寸创建
+    videoName = videoFile;
+    framesPerSecond = fps > 0 ? fps : 30;
+    startedNs = Telemetry::monotonicNs();
+    recording.storeRelease(1);
+    start(QThread::LowPriority);
+    return true;
+}
+
+void VideoRecorder::stopRecording()
+{
+    recording.storeRelease(0);
+    if (isRunning()) {
+        requestInterruption();
+        wait();
+    }
+    if (indexFile.isOpen())
+        indexFile.close();
+}
+
+void VideoRecorder::addFrame(const cv::Mat &frame, qint64 timestampNs)
+{
+    if (!recording.loadAcquire())
+        return;
+
+    int slot;
+    if (!freeSlots.pop(slot)) {
+        dropped.fetchAndAddRelaxed(1);
+        Perf::add(Perf::VideoFramesDropped);
+        return;
+    }
+    frame.copyTo(pool[slot]);       // 尺寸不变时复用帧池的内存
+    poolTimes[slot] = timestampNs;
+    readySlots.push(slot);
+}
+
+void VideoRecorder::run()
+{
+    cv::VideoWriter writer;
+    cv::Size frameSize;
+    quint32 frameNumber = 0;
+
+    bool stopping = false;
+    while (!stopping) {
+        stopping = isInterruptionRequested();
+
+        int slot;
+        bool wrote = false;
+        while (readySlots.pop(slot)) {
+            // 上一次停止时才提交的帧留在队列里，只归还不写入
+            if (poolTimes[slot] < startedNs) {
+                freeSlots.push(slot);
+                continue;
+            }
+
+            const cv::Mat &frame = pool[slot];
+            if (!writer.isOpened()) {
+                frameSize = frame.size();
+                writer.open(videoName.toStdString(), VideoCompat::fourcc('M', 'J', 'P', 'G'),
+                            framesPerSecond, frame.size());
+                if (!writer.isOpened()) {
+                    freeSlots.push(slot);
+                    recording.storeRelease(0);
+                    emit recordingFailed(tr("Can't create video file %1").arg(videoName));
+                    return;
+                }
+            }
+
+            // VideoWriter 遇到尺寸不同的帧会直接忽略，不报错；AVI 也不能中途改尺寸，所以停止录像
+            if (frame.size() != frameSize) {
+                freeSlots.push(slot);
+                writer.release();
+                recording.storeRelease(0);
+                emit recordingFailed(tr("Camera frame size changed from %1x%2 to %3x%4, recording %5 stopped")
+                                     .arg(frameSize.width).arg(frameSize.height)
+                                     .arg(frame.cols).arg(frame.rows).arg(videoName));
+                return;
+            }
+
+            writer.write(frame);
+
+            char entry[IndexEntrySize];
+            qToLittleEndian<quint32>(frameNumber++, reinterpret_cast<uchar *>(entry));
+            qToLittleEndian<qint64>(poolTimes[slot], reinterpret_cast<uchar *>(entry + 4));
+            indexFile.write(entry, IndexEntrySize);
+
+            freeSlots.push(slot);
+            wrote = true;
+        }
+
+        if (wrote)
+            indexFile.flush();
+        else if (!stopping)
+            msleep(5);
+    }
+
+    writer.release();
+}
+
+VideoIndex::VideoIndex()
+    : mapped(0),
+      entries(0),
+      count(0)
+{
+}
+
+VideoIndex::~VideoIndex()
+{
+    close();
+}
+
+bool VideoIndex::open(const QString &fileName)
+{
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < VideoRecorder::IndexHeaderSize)
+        return false;
+    mapped = file.map(0, file.size());
+    if (!mapped || memcmp(mapped, "GVVI", 4) != 0) {
+        close();
+        return false;
+    }
+
+    entries = mapped + VideoRecorder::IndexHeaderSize;
+    count = int((file.size() - VideoRecorder::IndexHeaderSize) / VideoRecorder::IndexEntrySize);
+    return true;
+}
+
+void VideoIndex::close()
+{
+    if (mapped)
+        file.unmap(mapped);
+    mapped = 0;
+    entries = 0;
+    count = 0;
+    file.close();
+}
+
+int VideoIndex::frameAt(qint64 timeNs) const
+{
+    if (!count)
+        return -1;
+
+    // 采集时刻递增，二分查找最后一个不晚于 timeNs 的
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (qFromLittleEndian<qint64>(entries + mid * VideoRecorder::IndexEntrySize + 4) <= timeNs)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    const int i = qMax(0, lo - 1);
+    return int(qFromLittleEndian<quint32>(entries + i * VideoRecorder::IndexEntrySize));
+}
+
+VideoReview::VideoReview()
+    : current(-1)
+{
+}
+
+bool VideoReview::open(const QString &videoFile, const QString &indexFile)
+{
+    close();
+    if (!index.open(indexFile) || !capture.open(videoFile.toStdString())) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void VideoReview::close()
+{
+    capture.release();
+    index.close();
+    current = -1;
+}
+
+const cv::Mat *VideoReview::frameAt(qint64 timeNs)
+{
+    const int n = isOpen() ? index.frameAt(timeNs) : -1;
+    if (n < 0 || n == current)
+        return 0;
+
+    // 顺序播放时直接读下一帧，其余情况才定位；MJPG 每帧都是关键帧，定位很快
+    if (n != current + 1)
+        capture.set(VideoCompat::PropPosFrames, n);
+    if (!capture.read(frame)) {
+        current = -1;
+        return 0;
+    }
+    current = n;
+    return &frame;
+}
@@ -0,0 +1,124 @@
+#ifndef VIDEORECORDER_H
+#define VIDEORECORDER_H
+
+#include <QThread>
+#include <QFile>
+#include <QAtomicInt>
+
+#include <opencv2/opencv.hpp>
+
+#include "spscqueue.h"
+
+// OpenCV 2.4 与 3.x 以后的属性常量和编码器写法不同
+namespace VideoCompat {
+#if CV_MAJOR_VERSION < 3
+const int PropFps = CV_CAP_PROP_FPS;
+const int PropPosFrames = CV_CAP_PROP_POS_FRAMES;
+const int JpegQuality = CV_IMWRITE_JPEG_QUALITY;
+inline int fourcc(char c1, char c2, char c3, char c4) { return CV_FOURCC(c1, c2, c3, c4); }
+#else
+const int PropFps = cv::CAP_PROP_FPS;
+const int PropPosFrames = cv::CAP_PROP_POS_FRAMES;
+const int JpegQuality = cv::IMWRITE_JPEG_QUALITY;
+inline int fourcc(char c1, char c2, char c3, char c4) { return cv::VideoWriter::fourcc(c1, c2, c3, c4); }
+#endif
+}
+
+// 摄像头录像：采集线程把帧复制进预先分配的帧池，编码和写文件在录像线程中，
+// 编码跟不上时丢帧并计数，不会拖慢采集和预览。
+// 帧池的下标经两个无锁队列在两个线程之间往返：free 由录像线程归还，ready 由采集线程提交。
+//
+// 视频为 MJPG 编码的 AVI，每一帧都是关键帧，可以直接定位。
+// 旁边的索引文件记录每一帧的采集时刻，时钟与 FlightRecorder 相同（Telemetry::monotonicNs），
+// 回放时按遥测时间二分查找即可找到对应的帧。索引文件格式（小端）：
+//   文件头 24 字节：char[4] "GVVI", u32 版本, i64 开始时的 ms since epoch,
+//                   i64 同一时刻的 Telemetry::monotonicNs()
+//   之后每帧 12 字节：u32 帧号（视频中的第几帧）, i64 采集时刻
+class VideoRecorder : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum {
+        Version = 1,
+        IndexHeaderSize = 24,
+        IndexEntrySize = 12,
+        PoolSize = 16
+    };
+
+    explicit VideoRecorder(QObject *parent = 0);
+    ~VideoRecorder();
+
+    // 以下在界面线程调用；fps 只写进容器，真实时刻以索引为准
+    bool startRecording(const QString &videoFile, const QString &indexFile, double fps);
+    void stopRecording();
+    bool isRecording() const { return recording.loadAcquire(); }
+    quint64 droppedFrames() const { return quint64(dropped.loadAcquire()); }
+
+    // 只能在采集线程调用；未在录像时直接返回
+    void addFrame(const cv::Mat &frame, qint64 timestampNs);
+
+signals:
+    void recordingFailed(const QString &error);
+
+protected:
+    void run();
+
+private:
+    QString videoName;
+    double framesPerSecond;
+    qint64 startedNs;
+    QFile indexFile;
+
+    cv::Mat pool[PoolSize];
+    qint64 poolTimes[PoolSize];
+    SpscQueue<int, PoolSize> freeSlots;     // 录像线程 -> 采集线程
+    SpscQueue<int, PoolSize> readySlots;    // 采集线程 -> 录像线程
+    QAtomicInt recording;
+    QAtomicInt dropped;
+};
+
+// 读取录像索引：按时刻找帧号
+class VideoIndex
+{
+public:
+    VideoIndex();
+    ~VideoIndex();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return entries != 0; }
+    int frameCount() const { return count; }
+
+    // 采集时刻不晚于 timeNs 的最后一帧；都比它晚时返回第一帧，没有帧时返回 -1
+    int frameAt(qint64 timeNs) const;
+
+private:
+    QFile file;
+    uchar *mapped;
+    const uchar *entries;
+    int count;
+};
+
+// 事后查看：按遥测时刻从录像中取对应的帧
+class VideoReview
+{
+public:
+    VideoReview();
+
+    // videoFile 和 indexFile 为同一次录像的两个文件
+    bool open(const QString &videoFile, const QString &indexFile);
+    void close();
+    bool isOpen() const { return capture.isOpened(); }
+
+    // timeNs 时刻显示的那一帧；与上一次相同或读取失败时返回 0
+    const cv::Mat *frameAt(qint64 timeNs);
+
+private:
+    VideoIndex index;
+    cv::VideoCapture capture;
+    cv::Mat frame;
+    int current;           // frame 中是第几帧
+};
+
+#endif // VIDEORECORDER_H
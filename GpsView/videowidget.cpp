@@ -0,0 +1,129 @@
+#include "videowidget.h"
+#include "trace.h"
+
+
+static const char *vertexShader =
+        "attribute vec2 position;\n"
+        "attribute vec2 texCoord;\n"
+        "uniform vec2 scale;\n"
+        "varying vec2 uv;\n"
+        "void main()\n"
+        "{\n"
+        "    uv = texCoord;\n"
+        "    gl_Position = vec4(position * scale, 0.0, 1.0);\n"
+        "}\n";
+
+// 纹理按 GL_RGB 上传但内容是 BGR，取样后交换通道
+static const char *fragmentShader =
+        "#ifdef GL_ES\n"
+        "precision mediump float;\n"
+        "#endif\n"
+        "uniform sampler2D frame;\n"
+        "varying vec2 uv;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_FragColor = vec4(texture2D(frame, uv).bgr, 1.0);\n"
+        "}\n";
+
+VideoWidget::VideoWidget(QWidget *parent)
+    : QOpenGLWidget(parent),
+      texture(0),
+      frameWidth(0),
+      frameHeight(0)
+{
+    setMinimumSize(320, 240);
+}
+
+VideoWidget::~VideoWidget()
+{
+    makeCurrent();
+    if (texture)
+        glDeleteTextures(1, &texture);
+    doneCurrent();
+}
+
+void VideoWidget::initializeGL()
+{
+    initializeOpenGLFunctions();
+
+    program.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader);
+    program.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader);
+    program.bindAttributeLocation("position", 0);
+    program.bindAttributeLocation("texCoord", 1);
+    program.link();
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // 非 2 的幂纹理在 GLES2 上只能用 CLAMP_TO_EDGE、不带 mipmap
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+void VideoWidget::setFrame(const uchar *data, int width, int height, int stride)
+{
+    if (!data || width <= 0 || height <= 0)
+        return;
+
+    makeCurrent();
+    if (!texture) {         // 控件还没显示过，GL 尚未初始化
+        doneCurrent();
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (width != frameWidth || height != frameHeight) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+        frameWidth = width;
+        frameHeight = height;
+    }
+
+    // GLES2 没有 GL_UNPACK_ROW_LENGTH，行间有填充时逐行上传
+    if (stride == width * 3) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, data);
+    } else {
+        for (int y = 0; y < height; ++y)
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, 1, GL_RGB, GL_UNSIGNED_BYTE,
+                            data + qint64(y) * stride);
+    }
+    doneCurrent();
+
+    update();
+}
+
+void VideoWidget::paintGL()
+{
+    Trace::Span span("paint video");
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!frameWidth || !frameHeight)
+        return;
+
+    // 等比缩放（KeepAspectRatio），留黑边
+    const float widgetAspect = float(width()) / qMax(1, height());
+    const float frameAspect = float(frameWidth) / frameHeight;
+    const float sx = frameAspect < widgetAspect ? frameAspect / widgetAspect : 1.0f;
+    const float sy = frameAspect < widgetAspect ? 1.0f : widgetAspect / frameAspect;
+
+    static const GLfloat positions[] = { -1, -1,   1, -1,   -1, 1,   1, 1 };
+    static const GLfloat texCoords[] = {  0,  1,   1,  1,    0, 0,   1, 0 };
+
+    program.bind();
+    program.setUniformValue("scale", sx, sy);
+    program.setUniformValue("frame", 0);
+    program.enableAttributeArray(0);
+    program.enableAttributeArray(1);
+    program.setAttributeArray(0, GL_FLOAT, positions, 2);
+    program.setAttributeArray(1, GL_FLOAT, texCoords, 2);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    program.disableAttributeArray(0);
+    program.disableAttributeArray(1);
+    program.release();
+}
@@ -0,0 +1,33 @@
+#ifndef VIDEOWIDGET_H
+#define VIDEOWIDGET_H
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+
+// 用 OpenGL 显示摄像头画面：原始 BGR 帧直接上传为纹理，
+// 颜色通道交换和等比缩放都在着色器里完成。
+// 着色器只用 GLSL 1.00 / OpenGL 2.0 的功能，软件渲染（Mesa llvmpipe）也能用。
+class VideoWidget : public QOpenGLWidget, protected QOpenGLFunctions
+{
+    Q_OBJECT
+
+public:
+    explicit VideoWidget(QWidget *parent = 0);
+    ~VideoWidget();
+
+    // 上传一帧 BGR888 图像，返回后调用方即可复用 data
+    void setFrame(const uchar *data, int width, int height, int stride);
+
+protected:
+    void initializeGL();
+    void paintGL();
+
+private:
+    QOpenGLShaderProgram program;
+    GLuint texture;
+    int frameWidth;
+    int frameHeight;
+};
+
+#endif // VIDEOWIDGET_H